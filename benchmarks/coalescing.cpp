@@ -0,0 +1,111 @@
+/**
+ * Simulates a cache-miss storm: waves of identical GET requests hit a local HTTP/1.1 server that answers after
+ * a short delay. Compares the upstream requests, the received bytes and the time per wave with and without
+ * coalescing.
+ *
+ *     curlio_benchmark_coalescing [waves] [requests per wave] [response size]
+ */
+#include <cURLio.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace CURLIO_ASIO_NS;
+
+std::atomic<std::size_t> upstream_requests{ 0 };
+std::atomic<std::size_t> upstream_bytes{ 0 };
+
+awaitable<void> serve(ip::tcp::socket socket, std::size_t size)
+{
+	const std::string body(size, 'x');
+	const std::string header = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(size) + "\r\n\r\n";
+	std::string request{};
+	try {
+		while (true) {
+			const auto end = co_await async_read_until(socket, dynamic_buffer(request), "\r\n\r\n", use_awaitable);
+			request.erase(0, end);
+			++upstream_requests;
+
+			// The backend needs a moment, so that the wave piles up.
+			steady_timer timer{ socket.get_executor(), std::chrono::milliseconds{ 20 } };
+			co_await timer.async_wait(use_awaitable);
+			const std::array<const_buffer, 2> buffers{ buffer(header), buffer(body) };
+			upstream_bytes += co_await async_write(socket, buffers, use_awaitable);
+		}
+	} catch (const std::exception& e) {
+	}
+}
+
+awaitable<void> listen(ip::tcp::acceptor& acceptor, std::size_t size)
+{
+	while (true) {
+		co_spawn(acceptor.get_executor(), serve(co_await acceptor.async_accept(use_awaitable), size), detached);
+	}
+}
+
+awaitable<void> fetch(cURLio::Session& session, std::string url, std::size_t& bytes)
+{
+	auto request = std::make_shared<cURLio::Request>(session);
+	request->set_option<CURLOPT_URL>(url.c_str());
+	auto response = co_await session.async_start(request, use_awaitable);
+	std::vector<char> data(64 * 1024);
+	while (true) {
+		cURLio::detail::asio_error_code ec{};
+		bytes += co_await response->async_read_some(buffer(data), redirect_error(use_awaitable, ec));
+		if (ec) {
+			break;
+		}
+	}
+}
+
+void run(const std::string& url, std::size_t waves, std::size_t requests, bool coalesce)
+{
+	io_context service{};
+	cURLio::Session session{ service.get_executor() };
+	session.set_option<CURLMOPT_MAXCONNECTS>(static_cast<long>(requests));
+	session.set_coalescing(coalesce);
+	upstream_requests = 0;
+	upstream_bytes    = 0;
+
+	std::size_t bytes = 0;
+	const auto start  = std::chrono::steady_clock::now();
+	for (std::size_t wave = 0; wave < waves; ++wave) {
+		for (std::size_t i = 0; i < requests; ++i) {
+			co_spawn(service, fetch(session, url + "/" + std::to_string(wave), bytes), detached);
+		}
+		service.run();
+		service.restart();
+	}
+	const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+
+	std::cout << (coalesce ? "coalesced  " : "independent") << "  upstream=" << upstream_requests
+	          << "  upstream MiB=" << upstream_bytes / 1024.0 / 1024
+	          << "  delivered MiB=" << bytes / 1024.0 / 1024 << "  " << duration.count() / waves
+	          << " ms/wave  attached=" << session.get_coalesced_count() << "\n";
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t waves    = argc > 1 ? std::stoul(argv[1]) : 20;
+	const std::size_t requests = argc > 2 ? std::stoul(argv[2]) : 200;
+	const std::size_t size     = argc > 3 ? std::stoul(argv[3]) : 256 * 1024;
+
+	io_context server_service{};
+	ip::tcp::acceptor acceptor{ server_service, { ip::address_v4::loopback(), 0 } };
+	co_spawn(server_service, listen(acceptor, size), detached);
+	std::thread server{ [&] { server_service.run(); } };
+
+	const std::string url = "http://127.0.0.1:" + std::to_string(acceptor.local_endpoint().port());
+
+	curl_global_init(CURL_GLOBAL_ALL);
+	run(url, waves, requests, false);
+	run(url, waves, requests, true);
+	curl_global_cleanup();
+
+	server_service.stop();
+	server.join();
+}
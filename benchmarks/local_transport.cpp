@@ -0,0 +1,120 @@
+/**
+ * Compares a Unix domain socket with loopback TCP for a local service. A minimal HTTP/1.1 keep-alive server
+ * listens on both transports in its own thread; the session then fetches small responses (req/s) and large
+ * responses (MiB/s) through each of them.
+ *
+ *     curlio_benchmark_local_transport [requests] [concurrency]
+ */
+#include <cURLio.hpp>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace CURLIO_ASIO_NS;
+
+constexpr std::size_t small_size = 64;
+constexpr std::size_t large_size = 4 * 1024 * 1024;
+
+/// Answers every request on the connection with `/small` or `/large` depending on the request target.
+template<typename Socket>
+awaitable<void> serve(Socket socket)
+{
+	const std::string large(large_size, 'x');
+	const std::string small(small_size, 'x');
+	std::string request{};
+	try {
+		while (true) {
+			const auto end = co_await async_read_until(socket, dynamic_buffer(request), "\r\n\r\n", use_awaitable);
+			const auto& body = request.find("GET /large") == 0 ? large : small;
+			request.erase(0, end);
+
+			const std::string header =
+			  "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+			const std::array<const_buffer, 2> buffers{ buffer(header), buffer(body) };
+			co_await async_write(socket, buffers, use_awaitable);
+		}
+	} catch (const std::exception& e) {
+	}
+}
+
+template<typename Acceptor>
+awaitable<void> listen(Acceptor& acceptor)
+{
+	while (true) {
+		co_spawn(acceptor.get_executor(), serve(co_await acceptor.async_accept(use_awaitable)), detached);
+	}
+}
+
+awaitable<void> worker(cURLio::Session& session, std::string url, const std::string& socket_path,
+                       std::size_t count, std::size_t& bytes)
+{
+	auto request = std::make_shared<cURLio::Request>(session);
+	request->set_option<CURLOPT_URL>(url.c_str());
+	if (!socket_path.empty()) {
+		request->set_option<CURLOPT_UNIX_SOCKET_PATH>(socket_path.c_str());
+	}
+
+	std::vector<char> data(64 * 1024);
+	for (std::size_t i = 0; i < count; ++i) {
+		auto response = co_await session.async_start(request, use_awaitable);
+		while (true) {
+			cURLio::detail::asio_error_code ec{};
+			bytes += co_await response->async_read_some(buffer(data), redirect_error(use_awaitable, ec));
+			if (ec) {
+				break;
+			}
+		}
+	}
+}
+
+void run(const char* name, const std::string& url, const std::string& socket_path, std::size_t requests,
+         std::size_t concurrency)
+{
+	io_context service{};
+	cURLio::Session session{ service.get_executor() };
+
+	std::size_t bytes = 0;
+	for (std::size_t i = 0; i < concurrency; ++i) {
+		const std::size_t count = requests / concurrency + (i < requests % concurrency ? 1 : 0);
+		co_spawn(service, worker(session, url, socket_path, count, bytes), detached);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	service.run();
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+	std::cout << name << "  " << requests / duration.count() << " req/s  "
+	          << bytes / duration.count() / 1024 / 1024 << " MiB/s\n";
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t requests    = argc > 1 ? std::stoul(argv[1]) : 20'000;
+	const std::size_t concurrency = argc > 2 ? std::stoul(argv[2]) : 16;
+	const std::string socket_path = "/tmp/curlio_benchmark_" + std::to_string(getpid()) + ".sock";
+
+	io_context server_service{};
+	ip::tcp::acceptor tcp_acceptor{ server_service, { ip::address_v4::loopback(), 0 } };
+	local::stream_protocol::acceptor local_acceptor{ server_service, socket_path };
+	co_spawn(server_service, listen(tcp_acceptor), detached);
+	co_spawn(server_service, listen(local_acceptor), detached);
+	std::thread server{ [&] { server_service.run(); } };
+
+	const std::string tcp_url = "http://127.0.0.1:" + std::to_string(tcp_acceptor.local_endpoint().port());
+
+	curl_global_init(CURL_GLOBAL_ALL);
+	run("tcp small", tcp_url + "/small", {}, requests, concurrency);
+	run("uds small", "http://localhost/small", socket_path, requests, concurrency);
+	run("tcp large", tcp_url + "/large", {}, requests / 100, concurrency);
+	run("uds large", "http://localhost/large", socket_path, requests / 100, concurrency);
+	curl_global_cleanup();
+
+	server_service.stop();
+	server.join();
+	std::remove(socket_path.c_str());
+}
@@ -0,0 +1,96 @@
+/**
+ * Measures the throughput of many small requests over a limited number of multiplexed HTTP/2 connections and
+ * compares it with one stream per connection. Needs a local h2c server, for example:
+ *
+ *     nghttpd --no-tls -d /path/to/files 8080
+ *     curlio_benchmark_multiplexing http://localhost:8080/small.txt 10000 1000
+ */
+#include <cURLio.hpp>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace CURLIO_ASIO_NS;
+
+struct Result {
+	std::size_t requests    = 0;
+	std::size_t failures    = 0;
+	std::size_t connections = 0;
+	std::size_t bytes       = 0;
+};
+
+awaitable<void> worker(cURLio::Session& session, std::string url, std::size_t count, bool multiplex,
+                       Result& result)
+{
+	auto request = std::make_shared<cURLio::Request>(session);
+	request->set_option<CURLOPT_URL>(url.c_str());
+	request->set_option<CURLOPT_HTTP_VERSION>(CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE);
+	request->set_option<CURLOPT_PIPEWAIT>(multiplex ? 1 : 0);
+
+	char data[16 * 1024];
+	for (std::size_t i = 0; i < count; ++i) {
+		try {
+			auto response = co_await session.async_start(request, use_awaitable);
+			while (true) {
+				cURLio::detail::asio_error_code ec{};
+				result.bytes += co_await response->async_read_some(buffer(data), redirect_error(use_awaitable, ec));
+				if (ec) {
+					break;
+				}
+			}
+			const long connections = co_await response->async_get_info<CURLINFO_NUM_CONNECTS>(use_awaitable);
+			result.connections += connections;
+			++result.requests;
+		} catch (const std::exception& e) {
+			++result.failures;
+		}
+	}
+}
+
+void run(const std::string& url, std::size_t requests, std::size_t concurrency, long connection_limit,
+         bool multiplex)
+{
+	io_context service{};
+	cURLio::Session session{ service.get_executor() };
+	session.set_option<CURLMOPT_PIPELINING>(multiplex ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+	session.set_option<CURLMOPT_MAX_HOST_CONNECTIONS>(connection_limit);
+	session.set_option<CURLMOPT_MAX_TOTAL_CONNECTIONS>(connection_limit);
+	session.set_option<CURLMOPT_MAXCONNECTS>(connection_limit);
+#if CURL_AT_LEAST_VERSION(7, 67, 0)
+	session.set_option<CURLMOPT_MAX_CONCURRENT_STREAMS>(100);
+#endif
+
+	Result result{};
+	for (std::size_t i = 0; i < concurrency; ++i) {
+		const std::size_t count = requests / concurrency + (i < requests % concurrency ? 1 : 0);
+		co_spawn(service, worker(session, url, count, multiplex, result), detached);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	service.run();
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+	std::cout << (multiplex ? "multiplexed" : "one stream ") << "  limit=" << connection_limit
+	          << "  connections=" << result.connections << "  requests=" << result.requests
+	          << "  failures=" << result.failures << "  " << result.requests / duration.count() << " req/s  "
+	          << result.bytes / duration.count() / 1024 / 1024 << " MiB/s\n";
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <h2c-url> [requests] [concurrency]\n";
+		return 1;
+	}
+
+	const std::string url         = argv[1];
+	const std::size_t requests    = argc > 2 ? std::stoul(argv[2]) : 10'000;
+	const std::size_t concurrency = argc > 3 ? std::stoul(argv[3]) : 1'000;
+
+	curl_global_init(CURL_GLOBAL_ALL);
+	for (const long limit : { 1, 2, 4, 8, 16 }) {
+		run(url, requests, concurrency, limit, true);
+	}
+	run(url, requests, concurrency, 64, false);
+	curl_global_cleanup();
+}
@@ -0,0 +1,98 @@
+/**
+ * Downloads large responses from a local HTTP/1.1 server with small reads. Compares the pauses per MiB, the
+ * CPU time and the throughput of pausing whenever nobody reads with the adaptive read-ahead.
+ *
+ *     curlio_benchmark_read_ahead [transfers] [response size] [read size]
+ */
+#include <cURLio.hpp>
+#include <array>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace CURLIO_ASIO_NS;
+
+awaitable<void> serve(ip::tcp::socket socket, std::size_t size)
+{
+	const std::string body(size, 'x');
+	const std::string header = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(size) + "\r\n\r\n";
+	std::string request{};
+	try {
+		while (true) {
+			const auto end = co_await async_read_until(socket, dynamic_buffer(request), "\r\n\r\n", use_awaitable);
+			request.erase(0, end);
+			const std::array<const_buffer, 2> buffers{ buffer(header), buffer(body) };
+			co_await async_write(socket, buffers, use_awaitable);
+		}
+	} catch (const std::exception& e) {
+	}
+}
+
+awaitable<void> listen(ip::tcp::acceptor& acceptor, std::size_t size)
+{
+	while (true) {
+		co_spawn(acceptor.get_executor(), serve(co_await acceptor.async_accept(use_awaitable), size), detached);
+	}
+}
+
+awaitable<void> fetch(cURLio::Session& session, std::string url, std::size_t read_size, std::size_t& bytes)
+{
+	auto request = std::make_shared<cURLio::Request>(session);
+	request->set_option<CURLOPT_URL>(url.c_str());
+	auto response = co_await session.async_start(request, use_awaitable);
+	std::vector<char> data(read_size);
+	while (true) {
+		cURLio::detail::asio_error_code ec{};
+		bytes += co_await response->async_read_some(buffer(data), redirect_error(use_awaitable, ec));
+		if (ec) {
+			break;
+		}
+	}
+}
+
+void run(const std::string& url, std::size_t transfers, std::size_t read_size, std::size_t read_ahead)
+{
+	io_context service{};
+	cURLio::Session session{ service.get_executor() };
+	session.set_read_ahead(read_ahead);
+
+	std::size_t bytes      = 0;
+	const auto start       = std::chrono::steady_clock::now();
+	const std::clock_t cpu = std::clock();
+	for (std::size_t i = 0; i < transfers; ++i) {
+		co_spawn(service, fetch(session, url, read_size, bytes), detached);
+	}
+	service.run();
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+	const double cpu_time                        = static_cast<double>(std::clock() - cpu) / CLOCKS_PER_SEC;
+	const double mib                             = bytes / 1024.0 / 1024;
+
+	std::cout << (read_ahead > 0 ? "read-ahead" : "pausing   ") << "  MiB=" << mib
+	          << "  pauses/MiB=" << session.get_pause_count() / mib << "  CPU ms/MiB=" << cpu_time * 1000 / mib
+	          << "  MiB/s=" << mib / duration.count() << "\n";
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t transfers = argc > 1 ? std::stoul(argv[1]) : 8;
+	const std::size_t size      = argc > 2 ? std::stoul(argv[2]) : 64 * 1024 * 1024;
+	const std::size_t read_size = argc > 3 ? std::stoul(argv[3]) : 1024;
+
+	io_context server_service{};
+	ip::tcp::acceptor acceptor{ server_service, { ip::address_v4::loopback(), 0 } };
+	co_spawn(server_service, listen(acceptor, size), detached);
+	std::thread server{ [&] { server_service.run(); } };
+
+	const std::string url = "http://127.0.0.1:" + std::to_string(acceptor.local_endpoint().port());
+
+	curl_global_init(CURL_GLOBAL_ALL);
+	run(url, transfers, read_size, 0);
+	run(url, transfers, read_size, 4 * 1024 * 1024);
+	curl_global_cleanup();
+
+	server_service.stop();
+	server.join();
+}
@@ -0,0 +1,135 @@
+/**
+ * Reads whole bodies of 1 KiB up to 1 GiB without a `Content-Length` from a local HTTP/1.1 server. Compares
+ * the throughput, the allocations per body and the allocated bytes relative to the body size of
+ * `quick::async_read_all()` into a string with `quick::async_read_all_chain()` into a buffer chain.
+ *
+ *     curlio_benchmark_read_all [max body size] [bytes per size]
+ */
+#include <cURLio.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+
+using namespace CURLIO_ASIO_NS;
+
+std::atomic<std::size_t> allocations{ 0 };
+std::atomic<std::size_t> allocated{ 0 };
+
+void* operator new(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	allocated.fetch_add(size, std::memory_order_relaxed);
+	if (const auto pointer = std::malloc(size)) {
+		return pointer;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+
+void operator delete(void* pointer, std::size_t /* size */) noexcept { std::free(pointer); }
+
+/// Answers `GET /<size>` with a chunked body of that size.
+awaitable<void> serve(ip::tcp::socket socket)
+{
+	const std::string header = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+	const std::string block(1024 * 1024, 'x');
+	std::string request{};
+	socket.set_option(ip::tcp::no_delay{ true });
+	try {
+		while (true) {
+			const auto end = co_await async_read_until(socket, dynamic_buffer(request), "\r\n\r\n", use_awaitable);
+			std::size_t size{ std::stoull(request.substr(request.find('/') + 1)) };
+			request.erase(0, end);
+			co_await async_write(socket, buffer(header), use_awaitable);
+			while (size > 0) {
+				const auto count = std::min(size, block.size());
+				char hex[20];
+				const auto hex_end = std::to_chars(hex, hex + sizeof(hex), count, 16).ptr;
+				const std::array<const_buffer, 4> buffers{ buffer(hex, hex_end - hex), buffer("\r\n", 2),
+					                                         buffer(block.data(), count), buffer("\r\n", 2) };
+				co_await async_write(socket, buffers, use_awaitable);
+				size -= count;
+			}
+			co_await async_write(socket, buffer("0\r\n\r\n", 5), use_awaitable);
+		}
+	} catch (const std::exception& e) {
+	}
+}
+
+awaitable<void> listen(ip::tcp::acceptor& acceptor)
+{
+	while (true) {
+		co_spawn(acceptor.get_executor(), serve(co_await acceptor.async_accept(use_awaitable)), detached);
+	}
+}
+
+template<bool Chain>
+awaitable<void> fetch(cURLio::Session& session, std::string url, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i) {
+		auto request = std::make_shared<cURLio::Request>(session);
+		request->set_option<CURLOPT_URL>(url.c_str());
+		auto response = co_await session.async_start(request, use_awaitable);
+		if constexpr (Chain) {
+			co_await cURLio::quick::async_read_all_chain(response, use_awaitable);
+		} else {
+			co_await cURLio::quick::async_read_all(response, use_awaitable);
+		}
+	}
+}
+
+template<bool Chain>
+void run(const std::string& url, std::size_t size, std::size_t count)
+{
+	io_context service{};
+	cURLio::Session session{ service.get_executor() };
+	// Warm up the connection.
+	co_spawn(service, fetch<Chain>(session, url + "/1", 1), detached);
+	service.run();
+	service.restart();
+
+	const auto start             = std::chrono::steady_clock::now();
+	const auto start_allocations = allocations.load();
+	const auto start_allocated   = allocated.load();
+	co_spawn(service, fetch<Chain>(session, url + "/" + std::to_string(size), count), detached);
+	service.run();
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+	const double mib                             = static_cast<double>(size) * count / 1024 / 1024;
+
+	std::cout << (Chain ? "chain " : "string") << "  size=" << size << "  bodies=" << count
+	          << "  allocations/body=" << static_cast<double>(allocations.load() - start_allocations) / count
+	          << "  allocated/size=" << static_cast<double>(allocated.load() - start_allocated) / count / size
+	          << "x  MiB/s=" << mib / duration.count() << "\n";
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t max_size = argc > 1 ? std::stoull(argv[1]) : 1024 * 1024 * 1024;
+	const std::size_t per_size = argc > 2 ? std::stoull(argv[2]) : 256 * 1024 * 1024;
+
+	io_context server_service{};
+	ip::tcp::acceptor acceptor{ server_service, { ip::address_v4::loopback(), 0 } };
+	co_spawn(server_service, listen(acceptor), detached);
+	std::thread server{ [&] { server_service.run(); } };
+
+	const std::string url = "http://127.0.0.1:" + std::to_string(acceptor.local_endpoint().port());
+
+	curl_global_init(CURL_GLOBAL_ALL);
+	for (std::size_t size = 1024; size <= max_size; size *= 32) {
+		const std::size_t count = std::clamp<std::size_t>(per_size / size, 1, 1000);
+		run<false>(url, size, count);
+		run<true>(url, size, count);
+	}
+	curl_global_cleanup();
+
+	server_service.stop();
+	server.join();
+}
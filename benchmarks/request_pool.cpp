@@ -0,0 +1,79 @@
+/**
+ * Measures short GET requests where every request is created anew, once with a fresh easy handle per request
+ * and once with handles recycled by a `RequestPool`. Needs a local HTTP/1.1 keep-alive server, for example:
+ *
+ *     curlio_benchmark_request_pool http://localhost:8080/small.txt 20000 16
+ */
+#include <cURLio.hpp>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace CURLIO_ASIO_NS;
+
+awaitable<void> worker(cURLio::Session& session, std::string url, std::size_t count, std::size_t& failures)
+{
+	std::vector<char> data(16 * 1024);
+	for (std::size_t i = 0; i < count; ++i) {
+		try {
+			auto request = std::make_shared<cURLio::Request>(session);
+			request->set_option<CURLOPT_URL>(url.c_str());
+			auto response = co_await session.async_start(request, use_awaitable);
+			while (true) {
+				cURLio::detail::asio_error_code ec{};
+				co_await response->async_read_some(buffer(data), redirect_error(use_awaitable, ec));
+				if (ec) {
+					break;
+				}
+			}
+		} catch (const std::exception& e) {
+			++failures;
+		}
+	}
+}
+
+void run(const std::string& url, std::size_t requests, std::size_t concurrency, bool pooled)
+{
+	io_context service{};
+	cURLio::Session session{ service.get_executor() };
+	const auto pool = std::make_shared<cURLio::RequestPool>(concurrency);
+	if (pooled) {
+		pool->set_base_option<CURLOPT_TCP_NODELAY>(1);
+		session.set_request_pool(pool);
+	}
+
+	std::size_t failures = 0;
+	for (std::size_t i = 0; i < concurrency; ++i) {
+		const std::size_t count = requests / concurrency + (i < requests % concurrency ? 1 : 0);
+		co_spawn(service, worker(session, url, count, failures), detached);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	service.run();
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+	const auto statistics = pool->get_statistics();
+	std::cout << (pooled ? "pooled  " : "unpooled") << "  " << requests / duration.count()
+	          << " req/s  failures=" << failures << "  reused=" << statistics.reused
+	          << "  created=" << statistics.created << "\n";
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <url> [requests] [concurrency]\n";
+		return 1;
+	}
+
+	const std::string url         = argv[1];
+	const std::size_t requests    = argc > 2 ? std::stoul(argv[2]) : 20'000;
+	const std::size_t concurrency = argc > 3 ? std::stoul(argv[3]) : 16;
+
+	curl_global_init(CURL_GLOBAL_ALL);
+	for (int i = 0; i < 2; ++i) {
+		run(url, requests, concurrency, false);
+		run(url, requests, concurrency, true);
+	}
+	curl_global_cleanup();
+}
@@ -0,0 +1,139 @@
+/**
+ * Compares the lookups done on every socket action: the socket map and the active request lookup of a
+ * finished transfer. Both are measured with 10k open sockets and easy handles.
+ */
+#include <cURLio.hpp>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+constexpr std::size_t socket_count = 10'000;
+constexpr std::size_t lookup_count = 10'000'000;
+
+struct Data {
+	curl_socket_t socket;
+	int wait_flags = 0;
+};
+
+template<typename Function>
+void measure(const char* name, std::size_t operations, Function&& function)
+{
+	const auto start = std::chrono::steady_clock::now();
+	function();
+	const auto duration = std::chrono::duration<double, std::nano>{ std::chrono::steady_clock::now() - start };
+	std::cout << name << ": " << duration.count() / operations << " ns/op\n";
+}
+
+int main(int argc, char** argv)
+{
+	curl_global_init(CURL_GLOBAL_ALL);
+
+	rlimit limit{};
+	getrlimit(RLIMIT_NOFILE, &limit);
+	limit.rlim_cur = std::max<rlim_t>(limit.rlim_cur, socket_count + 64);
+	if (setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+		std::cerr << "Failed to raise the file descriptor limit to " << limit.rlim_cur << "\n";
+		return 1;
+	}
+
+	std::vector<curl_socket_t> sockets;
+	for (std::size_t i = 0; i < socket_count; ++i) {
+		const auto socket = ::socket(AF_INET, SOCK_STREAM, 0);
+		if (socket < 0) {
+			std::cerr << "Failed to open socket " << i << "\n";
+			return 1;
+		}
+		sockets.push_back(socket);
+	}
+
+	std::mt19937 engine{ 42 };
+	std::vector<curl_socket_t> order;
+	order.reserve(lookup_count);
+	std::uniform_int_distribution<std::size_t> distribution{ 0, socket_count - 1 };
+	for (std::size_t i = 0; i < lookup_count; ++i) {
+		order.push_back(sockets[distribution(engine)]);
+	}
+
+	std::size_t checksum = 0;
+
+	{
+		std::map<curl_socket_t, std::shared_ptr<Data>> map;
+		measure("std::map insert", socket_count, [&] {
+			for (const auto socket : sockets) {
+				map.insert({ socket, std::make_shared<Data>(Data{ socket }) });
+			}
+		});
+		measure("std::map find", lookup_count, [&] {
+			for (const auto socket : order) {
+				checksum += map.find(socket)->second->socket;
+			}
+		});
+		measure("std::map erase", socket_count, [&] {
+			for (const auto socket : sockets) {
+				map.erase(socket);
+			}
+		});
+	}
+
+	{
+		cURLio::detail::SocketTable<std::shared_ptr<Data>> table;
+		measure("SocketTable insert", socket_count, [&] {
+			for (const auto socket : sockets) {
+				table.insert(socket, std::make_shared<Data>(Data{ socket }));
+			}
+		});
+		measure("SocketTable find", lookup_count, [&] {
+			for (const auto socket : order) {
+				checksum += (*table.find(socket))->socket;
+			}
+		});
+		measure("SocketTable erase", socket_count, [&] {
+			for (const auto socket : sockets) {
+				table.erase(socket);
+			}
+		});
+	}
+
+	// Active request lookup as done for every CURLMSG_DONE.
+	std::vector<CURL*> handles;
+	std::map<CURL*, std::shared_ptr<Data>> active;
+	for (std::size_t i = 0; i < socket_count; ++i) {
+		const auto handle = curl_easy_init();
+		const auto data   = std::make_shared<Data>(Data{ sockets[i] });
+		curl_easy_setopt(handle, CURLOPT_PRIVATE, data.get());
+		active.insert({ handle, data });
+		handles.push_back(handle);
+	}
+	std::vector<CURL*> handle_order;
+	handle_order.reserve(lookup_count);
+	for (std::size_t i = 0; i < lookup_count; ++i) {
+		handle_order.push_back(handles[distribution(engine)]);
+	}
+	measure("std::map<CURL*> find", lookup_count, [&] {
+		for (const auto handle : handle_order) {
+			checksum += active.find(handle)->second->socket;
+		}
+	});
+	measure("CURLINFO_PRIVATE", lookup_count, [&] {
+		for (const auto handle : handle_order) {
+			char* data = nullptr;
+			curl_easy_getinfo(handle, CURLINFO_PRIVATE, &data);
+			checksum += reinterpret_cast<Data*>(data)->socket;
+		}
+	});
+
+	std::cout << "Checksum: " << checksum << "\n";
+
+	for (const auto handle : handles) {
+		curl_easy_cleanup(handle);
+	}
+	for (const auto socket : sockets) {
+		close(socket);
+	}
+	curl_global_cleanup();
+}
@@ -0,0 +1,84 @@
+/**
+ * Compares arming and cancelling 100k deadlines with one `steady_timer` each and with the timer wheel of the
+ * session, as done for every transfer started with a deadline that finishes in time.
+ */
+#include <cURLio.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+constexpr std::size_t timer_count = 100'000;
+
+template<typename Function>
+void measure(const char* name, std::size_t operations, Function&& function)
+{
+	const auto start = std::chrono::steady_clock::now();
+	function();
+	const auto duration = std::chrono::duration<double, std::nano>{ std::chrono::steady_clock::now() - start };
+	std::cout << name << ": " << duration.count() / operations << " ns/op\n";
+}
+
+int main(int argc, char** argv)
+{
+	std::mt19937 engine{ 42 };
+	std::uniform_int_distribution<int> distribution{ 1'000, 60'000 };
+	const auto now = std::chrono::steady_clock::now();
+	std::vector<std::chrono::steady_clock::time_point> deadlines;
+	for (std::size_t i = 0; i < timer_count; ++i) {
+		deadlines.push_back(now + std::chrono::milliseconds{ distribution(engine) });
+	}
+
+	std::size_t fired = 0;
+
+	{
+		CURLIO_ASIO_NS::io_context service{};
+		std::vector<std::unique_ptr<CURLIO_ASIO_NS::steady_timer>> timers;
+		timers.reserve(timer_count);
+		measure("steady_timer arm", timer_count, [&] {
+			for (const auto deadline : deadlines) {
+				timers.push_back(std::make_unique<CURLIO_ASIO_NS::steady_timer>(service, deadline));
+				timers.back()->async_wait([&](const auto& ec) { fired += !ec; });
+			}
+		});
+		measure("steady_timer cancel", timer_count, [&] {
+			for (const auto& timer : timers) {
+				timer->cancel();
+			}
+			service.run();
+		});
+	}
+
+	{
+		cURLio::detail::TimerWheel<cURLio::detail::Function<void()>> wheel{ std::chrono::milliseconds{ 1 }, now };
+		std::vector<std::uint64_t> ids;
+		ids.reserve(timer_count);
+		measure("TimerWheel schedule", timer_count, [&] {
+			for (const auto deadline : deadlines) {
+				ids.push_back(wheel.schedule(deadline, [&] { ++fired; }));
+			}
+		});
+		measure("TimerWheel cancel", timer_count, [&] {
+			for (const auto id : ids) {
+				wheel.cancel(id);
+			}
+		});
+
+		for (const auto deadline : deadlines) {
+			wheel.schedule(deadline, [&] { ++fired; });
+		}
+		std::vector<cURLio::detail::Function<void()>> expired;
+		measure("TimerWheel expire", timer_count, [&] {
+			for (auto time = now; !wheel.empty(); time += std::chrono::milliseconds{ 10 }) {
+				wheel.advance(time, expired);
+				for (auto& callback : expired) {
+					callback();
+				}
+				expired.clear();
+			}
+		});
+	}
+
+	std::cout << "Fired: " << fired << "\n";
+}
@@ -1,8 +1,14 @@
 #pragma once
 
+#include "cURLio/basic_caching_session.inl"
 #include "cURLio/basic_request.inl"
+#include "cURLio/basic_resolver.inl"
 #include "cURLio/basic_response.inl"
 #include "cURLio/basic_session.inl"
+#include "cURLio/basic_session_pool.inl"
+#include "cURLio/basic_share.inl"
+#include "cURLio/quick/download.hpp"
 #include "cURLio/quick/form.hpp"
 #include "cURLio/quick/ignore_all.hpp"
+#include "cURLio/quick/parallel_download.hpp"
 #include "cURLio/quick/reader.hpp"
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "config.hpp"
+#include "detail/asio_include.hpp"
+#include "detail/function.hpp"
+#include "detail/header_collector.hpp"
+#include "detail/shared_transfer.hpp"
+#include "disk_cache.hpp"
+#include "fwd.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cURLio {
+
+/**
+ * Answers `GET` requests from an in-memory LRU cache in front of a session. Responses are cached according to
+ * their `Cache-Control`, `Expires`, `Age` and `Vary` headers as long as they fit into the byte budget. Fresh
+ * entries are served without touching cURL. Stale entries with an `ETag` or a `Last-Modified` header are
+ * revalidated with `If-None-Match` or `If-Modified-Since`, and a `304 Not Modified` is answered with the
+ * cached response.
+ *
+ * Fetched responses are read from a shared transfer like coalesced ones (see
+ * `BasicSession::set_coalescing()`), so the cache keeps the received chunks instead of copying them.
+ * Requests without a URL, with a range, credentials or cookies (see `BasicSession::set_coalescing()`) or a
+ * request `Cache-Control` of `no-store` bypass the cache and `no-cache` skips fresh entries. The URL and the
+ * method must be set with `BasicRequest::set_option()`; a method set on the native handle is only noticed
+ * when storing the response, so such a request might still be answered from the cache. Only one variant is
+ * kept per URL. Large bodies can be kept on disk instead (see `set_disk_cache()`). The session must outlive
+ * the cache.
+ *
+ * @tparam Executor The ASIO executor type. Most of the time `CURLIO_ASIO_NS::any_io_executor` is enough.
+ */
+template<typename Executor>
+class BasicCachingSession {
+public:
+	using session_type     = BasicSession<Executor>;
+	using request_pointer  = std::shared_ptr<BasicRequest<Executor>>;
+	using response_pointer = std::shared_ptr<BasicResponse<Executor>>;
+
+	struct Statistics {
+		/// Requests answered with a fresh entry.
+		std::size_t hits;
+		/// Requests answered with a stale entry after a `304 Not Modified`.
+		std::size_t revalidated;
+		/// Requests that needed a full response.
+		std::size_t misses;
+		std::size_t entries;
+		/// The bytes taken by the cached bodies and headers.
+		std::size_t size;
+	};
+
+	/// @param max_size The budget for the cached bodies and headers. Larger responses are not cached.
+	BasicCachingSession(session_type& session, std::size_t max_size = 64 * 1024 * 1024);
+	BasicCachingSession(const BasicCachingSession& copy) = delete;
+	BasicCachingSession(BasicCachingSession&& move)      = delete;
+
+	/**
+	 * Like `BasicSession::async_start()` but answers from the cache if possible. A response served from the
+	 * cache has its headers and body, but its request did not run, hence `async_get_info()` does not report
+	 * the status. The response of a revalidation belongs to a copy of the request with the conditional headers.
+	 */
+	auto async_start(request_pointer request, auto&& token);
+#if !defined(_WIN32)
+	/**
+	 * Keeps bodies of at least `min_size` bytes in the disk cache instead of the memory. The body is written to
+	 * the disk while it is received; the start is held back until the size is reached. A fetched body only
+	 * ever lives in one of the tiers. Pass an empty pointer to stop using the disk.
+	 *
+	 * The body is written with blocking calls on the strand of the session as the data arrives, so a slow disk
+	 * stalls all transfers of the session for as long as the writes take. Use a fast local disk or a session of
+	 * its own for the cached traffic.
+	 */
+	void set_disk_cache(std::shared_ptr<DiskCache> cache, std::size_t min_size = 1024 * 1024);
+#endif
+	/// Removes all entries from the memory.
+	void clear();
+	/// Safe to call from any thread.
+	CURLIO_NO_DISCARD Statistics get_statistics() const noexcept;
+	CURLIO_NO_DISCARD session_type& get_session() noexcept;
+
+	BasicCachingSession& operator=(const BasicCachingSession& copy) = delete;
+	BasicCachingSession& operator=(BasicCachingSession&& move)      = delete;
+
+private:
+	struct Entry {
+		std::string url;
+		std::shared_ptr<detail::SharedTransfer::Chunk> body;
+		std::size_t body_size;
+		detail::HeaderCollector::fields_type fields;
+		/// The values of the request headers named by `Vary`.
+		std::vector<std::pair<std::string, std::string>> vary;
+		std::chrono::steady_clock::time_point expires;
+		/// The size counted against the budget.
+		std::size_t size;
+		/// Whether the entry belongs to the disk cache and is not held in the memory.
+		bool on_disk = false;
+	};
+	/// A transfer whose response might be cached. Only accessed on the strand of the session.
+	struct Fetch {
+		request_pointer request;
+		/// Kept until the response is handed to the user.
+		response_pointer response;
+		request_pointer running_request;
+		std::shared_ptr<detail::SharedTransfer> shared;
+		/// The start of the body. Released once the body gets too large.
+		std::shared_ptr<detail::SharedTransfer::Chunk> head;
+		/// The entry which is revalidated.
+		std::shared_ptr<Entry> entry;
+		std::size_t sections = 0;
+		detail::Function<void(detail::asio_error_code, response_pointer)> handler;
+#if !defined(_WIN32)
+		std::shared_ptr<DiskCache> disk{};
+		std::optional<DiskCache::Writer> writer{};
+		/// The position up to which the body was written to the disk.
+		detail::SharedTransfer::Cursor tee{};
+#endif
+	};
+
+	session_type& _session;
+	std::size_t _max_size;
+	std::size_t _size = 0;
+	/// The most recently used entry first.
+	std::list<std::shared_ptr<Entry>> _entries{};
+	std::map<std::string, typename std::list<std::shared_ptr<Entry>>::iterator> _index{};
+	std::atomic<std::size_t> _hits{ 0 };
+	std::atomic<std::size_t> _revalidated{ 0 };
+	std::atomic<std::size_t> _misses{ 0 };
+	std::atomic<std::size_t> _entry_count{ 0 };
+	std::atomic<std::size_t> _used_size{ 0 };
+#if !defined(_WIN32)
+	std::shared_ptr<DiskCache> _disk{};
+	std::size_t _disk_min_size = 0;
+#endif
+
+	/// Looks up the request and serves, revalidates or fetches it. Runs on the strand.
+	void _start(request_pointer request,
+	            detail::Function<void(detail::asio_error_code, response_pointer)> handler);
+	/// Returns the entry of the memory or the disk matching the request.
+	std::shared_ptr<Entry> _lookup(const BasicRequest<Executor>& request);
+	/// Starts the request on the session and caches its response.
+	void _fetch(request_pointer request, std::shared_ptr<Entry> entry, bool store,
+	            detail::Function<void(detail::asio_error_code, response_pointer)> handler);
+	/// Called on every change of the shared transfer. Returns whether it wants to be called again.
+	bool _observe(const std::shared_ptr<Fetch>& fetch);
+#if !defined(_WIN32)
+	/// Writes the received data to the disk once the body is large enough.
+	void _tee(Fetch& fetch);
+	/// Stores the body in the disk cache. Returns whether the body belongs on the disk.
+	bool _store_on_disk(Fetch& fetch, const detail::HeaderCollector::fields_type& fields,
+	                    std::vector<std::pair<std::string, std::string>>& vary,
+	                    std::chrono::steady_clock::time_point expires);
+	static DiskCache::clock_type::time_point _to_system(std::chrono::steady_clock::time_point time) noexcept;
+#endif
+	/// Hands the response to the user and releases the reference of the fetch later.
+	void _deliver(Fetch& fetch, response_pointer response);
+	/// Creates a response that replays the entry.
+	response_pointer _replay(const request_pointer& request, const Entry& entry);
+	/// Computes the expiry from the fields. Returns nothing if the response must not be cached.
+	static std::optional<std::chrono::steady_clock::time_point>
+	  _expiry(const detail::HeaderCollector::fields_type& fields);
+	void _insert(std::shared_ptr<Entry> entry);
+	void _erase(typename std::list<std::shared_ptr<Entry>>::iterator entry) noexcept;
+	void _update_statistics() noexcept;
+};
+
+using CachingSession = BasicCachingSession<CURLIO_ASIO_NS::any_io_executor>;
+
+} // namespace cURLio
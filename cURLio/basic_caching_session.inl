@@ -0,0 +1,473 @@
+#pragma once
+
+#include "basic_caching_session.hpp"
+#include "basic_request.hpp"
+#include "basic_response.hpp"
+#include "basic_session.hpp"
+#include "debug.hpp"
+#include "detail/cache_control.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <ctime>
+#include <functional>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace cURLio {
+
+template<typename Executor>
+inline BasicCachingSession<Executor>::BasicCachingSession(session_type& session, std::size_t max_size)
+    : _session{ session }, _max_size{ max_size }
+{}
+
+template<typename Executor>
+inline auto BasicCachingSession<Executor>::async_start(request_pointer request, auto&& token)
+{
+	return CURLIO_ASIO_NS::async_initiate<decltype(token), void(detail::asio_error_code, response_pointer)>(
+	  [this, request = std::move(request)](auto handler) mutable {
+		  auto executor = CURLIO_ASIO_NS::get_associated_executor(handler, _session.get_executor());
+		  CURLIO_ASIO_NS::dispatch(_session.get_strand(), [this, request = std::move(request),
+		                                                   handler  = std::move(handler),
+		                                                   executor = std::move(executor)]() mutable {
+			  _start(std::move(request), [handler = std::move(handler), executor = std::move(executor)](
+			                               detail::asio_error_code ec, response_pointer response) mutable {
+				  CURLIO_ASIO_NS::post(std::move(executor), std::bind(std::move(handler), ec, std::move(response)));
+			  });
+		  });
+	  },
+	  token);
+}
+
+#if !defined(_WIN32)
+template<typename Executor>
+inline void BasicCachingSession<Executor>::set_disk_cache(std::shared_ptr<DiskCache> cache,
+                                                          std::size_t min_size)
+{
+	CURLIO_ASIO_NS::dispatch(_session.get_strand(), [this, cache = std::move(cache), min_size]() mutable {
+		_disk          = std::move(cache);
+		_disk_min_size = min_size;
+	});
+}
+#endif
+
+template<typename Executor>
+inline void BasicCachingSession<Executor>::clear()
+{
+	CURLIO_ASIO_NS::dispatch(_session.get_strand(), [this] {
+		_entries.clear();
+		_index.clear();
+		_size = 0;
+		_update_statistics();
+	});
+}
+
+template<typename Executor>
+inline typename BasicCachingSession<Executor>::Statistics
+  BasicCachingSession<Executor>::get_statistics() const noexcept
+{
+	return { _hits.load(std::memory_order_relaxed), _revalidated.load(std::memory_order_relaxed),
+		       _misses.load(std::memory_order_relaxed), _entry_count.load(std::memory_order_relaxed),
+		       _used_size.load(std::memory_order_relaxed) };
+}
+
+template<typename Executor>
+inline typename BasicCachingSession<Executor>::session_type&
+  BasicCachingSession<Executor>::get_session() noexcept
+{
+	return _session;
+}
+
+template<typename Executor>
+inline void BasicCachingSession<Executor>::_start(
+  request_pointer request, detail::Function<void(detail::asio_error_code, response_pointer)> handler)
+{
+	const auto control = detail::parse_cache_control(request->_header("Cache-Control").value_or(""));
+	// Without a URL the request has no key, and credentials or cookies make the response its own.
+	if (request->_method() != "GET" || request->_url.empty() || request->_personal ||
+	    request->_header("Range").has_value() || request->_header("Authorization").has_value() ||
+	    request->_header("Cookie").has_value() || control.no_store) {
+		_fetch(std::move(request), {}, false, std::move(handler));
+		return;
+	}
+
+	if (const auto entry = _lookup(*request); entry != nullptr) {
+		if (!control.no_cache && std::chrono::steady_clock::now() < entry->expires) {
+			CURLIO_DEBUG("Serving " << request->_url << " from the cache");
+			_hits.fetch_add(1, std::memory_order_relaxed);
+			handler({}, _replay(request, *entry));
+			return;
+		}
+
+		const auto etag          = entry->fields.find("ETag");
+		const auto last_modified = entry->fields.find("Last-Modified");
+		if (etag != entry->fields.end() || last_modified != entry->fields.end()) {
+			CURLIO_DEBUG("Revalidating " << request->_url);
+			try {
+				auto conditional = std::make_shared<BasicRequest<Executor>>(*request);
+				if (etag != entry->fields.end()) {
+					conditional->append_header(("If-None-Match: " + etag->second).c_str());
+				}
+				if (last_modified != entry->fields.end()) {
+					conditional->append_header(("If-Modified-Since: " + last_modified->second).c_str());
+				}
+				_fetch(std::move(conditional), entry, true, std::move(handler));
+				return;
+			} catch (const std::system_error& e) {
+				CURLIO_ERROR("Failed to create the conditional request: " << e.what());
+			}
+		}
+	}
+
+	_fetch(std::move(request), {}, true, std::move(handler));
+}
+
+template<typename Executor>
+inline std::shared_ptr<typename BasicCachingSession<Executor>::Entry>
+  BasicCachingSession<Executor>::_lookup(const BasicRequest<Executor>& request)
+{
+	const auto matches = [&request](const Entry& entry) {
+		return std::all_of(entry.vary.begin(), entry.vary.end(), [&](const auto& header) {
+			return request._header(header.first).value_or("") == header.second;
+		});
+	};
+
+	if (const auto found = _index.find(request._url); found != _index.end()) {
+		if (!matches(**found->second)) {
+			return {};
+		}
+		_entries.splice(_entries.begin(), _entries, found->second);
+		return *found->second;
+	}
+
+#if !defined(_WIN32)
+	if (_disk != nullptr) {
+		if (auto hit = _disk->lookup(request._url); hit.has_value()) {
+			// The mapped body is replayed as a single chunk without copying it.
+			auto head = std::make_shared<detail::SharedTransfer::Chunk>();
+			if (hit->body != nullptr) {
+				head->next        = std::make_shared<detail::SharedTransfer::Chunk>();
+				head->next->data  = hit->body.get();
+				head->next->size  = hit->record.size;
+				head->next->owner = std::move(hit->body);
+			}
+			const auto expires =
+			  std::chrono::steady_clock::now() +
+			  std::chrono::duration_cast<std::chrono::steady_clock::duration>(hit->record.expires -
+			                                                                  DiskCache::clock_type::now());
+			auto entry =
+			  std::make_shared<Entry>(Entry{ std::move(hit->record.key), std::move(head), hit->record.size,
+			                                 std::move(hit->record.fields), std::move(hit->record.vary), expires, 0,
+			                                 true });
+			if (matches(*entry)) {
+				return entry;
+			}
+		}
+	}
+#endif
+	return {};
+}
+
+template<typename Executor>
+inline void BasicCachingSession<Executor>::_fetch(
+  request_pointer request, std::shared_ptr<Entry> entry, bool store,
+  detail::Function<void(detail::asio_error_code, response_pointer)> handler)
+{
+	if (!store) {
+		_misses.fetch_add(1, std::memory_order_relaxed);
+		_session._async_start(std::move(request), std::nullopt, true, std::move(handler));
+		return;
+	}
+
+	// Reading through a shared transfer lets the cache keep the chunks of the body.
+	request->_shared = std::make_shared<detail::SharedTransfer>(std::string{}, _max_size);
+	const auto fetch =
+	  std::make_shared<Fetch>(Fetch{ request, {}, {}, {}, {}, std::move(entry), 0, std::move(handler) });
+	_session._async_start(
+	  std::move(request), std::nullopt, true,
+	  CURLIO_ASIO_NS::bind_executor(
+	    _session.get_strand(), [this, fetch](detail::asio_error_code ec, response_pointer response) {
+		    if (ec) {
+			    fetch->request->_shared.reset();
+			    _misses.fetch_add(1, std::memory_order_relaxed);
+			    std::exchange(fetch->handler, {})(ec, {});
+			    return;
+		    }
+
+		    fetch->response        = response;
+		    fetch->running_request = response->_request;
+		    fetch->shared          = response->_shared;
+		    fetch->head            = fetch->shared->head();
+#if !defined(_WIN32)
+		    if (_disk != nullptr) {
+			    fetch->disk = _disk;
+			    fetch->tee  = fetch->shared->begin();
+		    }
+#endif
+		    if (_observe(fetch)) {
+			    fetch->shared->subscribe([this, fetch] { return _observe(fetch); });
+		    }
+	    }));
+}
+
+template<typename Executor>
+inline bool BasicCachingSession<Executor>::_observe(const std::shared_ptr<Fetch>& fetch)
+{
+	const auto& shared = *fetch->shared;
+	const auto handle  = fetch->running_request->native_handle();
+	if (fetch->head != nullptr && shared.size() > _max_size) {
+		fetch->head.reset();
+	}
+#if !defined(_WIN32)
+	if (fetch->tee.chunk != nullptr) {
+		_tee(*fetch);
+	}
+#endif
+
+	// Decide with every new header section whether it answers the request.
+	if (fetch->handler && fetch->sections < shared.sections().size()) {
+		fetch->sections    = shared.sections().size();
+		const auto& fields = shared.sections().back();
+		long status        = 0;
+		CURLIO_EASY_CHECK(curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status));
+		if (status == 304 && fetch->entry != nullptr) {
+			CURLIO_DEBUG("Revalidated " << fetch->entry->url);
+			for (const auto& [key, value] : fields) {
+				fetch->entry->fields.insert_or_assign(key, value);
+			}
+			fetch->entry->expires =
+			  _expiry(fetch->entry->fields).value_or(std::chrono::steady_clock::time_point{});
+#if !defined(_WIN32)
+			if (fetch->entry->on_disk && _disk != nullptr) {
+				_disk->update(fetch->entry->url, fetch->entry->fields, _to_system(fetch->entry->expires));
+			}
+#endif
+			_revalidated.fetch_add(1, std::memory_order_relaxed);
+			_deliver(*fetch, _replay(fetch->request, *fetch->entry));
+			return false;
+		} else if (!(status >= 100 && status < 200) &&
+		           !(status >= 300 && status < 400 && fields.count("Location") > 0)) {
+			_misses.fetch_add(1, std::memory_order_relaxed);
+			_deliver(*fetch, fetch->response);
+		}
+	}
+	if (!shared.finished()) {
+		return true;
+	} else if (fetch->handler) {
+		_misses.fetch_add(1, std::memory_order_relaxed);
+		_deliver(*fetch, fetch->response);
+	}
+
+	long status = 0;
+	CURLIO_EASY_CHECK(curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status));
+	if (shared.reason() != CURLIO_ASIO_NS::error::eof || shared.sections().empty() || status != 200) {
+		return false;
+	}
+#if CURL_AT_LEAST_VERSION(7, 72, 0)
+	// Catches a method which was set on the native handle and is not seen by `_method()`.
+	const char* method = nullptr;
+	CURLIO_EASY_CHECK(curl_easy_getinfo(handle, CURLINFO_EFFECTIVE_METHOD, &method));
+	if (method == nullptr || std::string_view{ method } != "GET") {
+		return false;
+	}
+#endif
+
+	const auto& fields = shared.sections().back();
+	// A connection closed by the server early also ends the transfer with eof.
+	if (const auto length = fields.find("Content-Length"); length != fields.end()) {
+		std::size_t expected = 0;
+		const auto end       = length->second.data() + length->second.size();
+		if (const auto [ptr, ec] = std::from_chars(length->second.data(), end, expected);
+		    ec != std::errc{} || ptr != end || expected != shared.size()) {
+			return false;
+		}
+	}
+	const auto expires = _expiry(fields);
+	if (!expires.has_value()) {
+		return false;
+	}
+	std::vector<std::pair<std::string, std::string>> vary{};
+	if (const auto names = fields.find("Vary"); names != fields.end()) {
+		for (auto& name : detail::split_list(names->second)) {
+			if (name == "*") {
+				return false;
+			}
+			auto value = std::string{ fetch->request->_header(name).value_or("") };
+			vary.emplace_back(std::move(name), std::move(value));
+		}
+	}
+
+#if !defined(_WIN32)
+	if (_store_on_disk(*fetch, fields, vary, *expires)) {
+		return false;
+	}
+#endif
+	if (fetch->head != nullptr) {
+#if !defined(_WIN32)
+		if (_disk != nullptr) {
+			_disk->erase(fetch->request->_url);
+		}
+#endif
+		_insert(std::make_shared<Entry>(
+		  Entry{ fetch->request->_url, fetch->head, shared.size(), fields, std::move(vary), *expires, 0 }));
+	}
+	return false;
+}
+
+#if !defined(_WIN32)
+template<typename Executor>
+inline void BasicCachingSession<Executor>::_tee(Fetch& fetch)
+{
+	// The cursor holds back the start of the body until it is clear that the body belongs on the disk.
+	if (!fetch.writer.has_value()) {
+		if (fetch.shared->size() < _disk_min_size) {
+			return;
+		}
+		auto writer = fetch.disk->begin();
+		if (!writer.has_value()) {
+			fetch.tee = {};
+			return;
+		}
+		fetch.writer.emplace(std::move(*writer));
+	}
+
+	for (auto data = fetch.shared->peek(fetch.tee); data.second > 0; data = fetch.shared->peek(fetch.tee)) {
+		if (!fetch.writer->write(data.first, data.second)) {
+			fetch.writer.reset();
+			fetch.tee = {};
+			return;
+		}
+		fetch.tee.offset += data.second;
+	}
+}
+
+template<typename Executor>
+inline bool BasicCachingSession<Executor>::_store_on_disk(
+  Fetch& fetch, const detail::HeaderCollector::fields_type& fields,
+  std::vector<std::pair<std::string, std::string>>& vary, std::chrono::steady_clock::time_point expires)
+{
+	if (!fetch.writer.has_value()) {
+		return false;
+	}
+	DiskCache::Record record{ fetch.request->_url, fields, std::move(vary), _to_system(expires), 0 };
+	if (!fetch.writer->commit(std::move(record))) {
+		return true;
+	}
+
+	CURLIO_DEBUG("Cached " << fetch.request->_url << " on the disk");
+	if (const auto found = _index.find(fetch.request->_url); found != _index.end()) {
+		_erase(found->second);
+		_update_statistics();
+	}
+	return true;
+}
+
+template<typename Executor>
+inline DiskCache::clock_type::time_point
+  BasicCachingSession<Executor>::_to_system(std::chrono::steady_clock::time_point time) noexcept
+{
+	return DiskCache::clock_type::now() +
+	       std::chrono::duration_cast<DiskCache::clock_type::duration>(time - std::chrono::steady_clock::now());
+}
+#endif
+
+template<typename Executor>
+inline void BasicCachingSession<Executor>::_deliver(Fetch& fetch, response_pointer response)
+{
+	// Might be called within a cURL callback where the last reference of a transfer must not be released.
+	if (fetch.response) {
+		CURLIO_ASIO_NS::post(_session.get_strand(), [response = std::move(fetch.response)] {});
+	}
+	std::exchange(fetch.handler, {})({}, std::move(response));
+}
+
+template<typename Executor>
+inline typename BasicCachingSession<Executor>::response_pointer
+  BasicCachingSession<Executor>::_replay(const request_pointer& request, const Entry& entry)
+{
+	auto response = _session._make_response(request);
+	response->_subscribe(detail::SharedTransfer::replay(entry.body, entry.body_size, entry.fields), true);
+	return response;
+}
+
+template<typename Executor>
+inline std::optional<std::chrono::steady_clock::time_point>
+  BasicCachingSession<Executor>::_expiry(const detail::HeaderCollector::fields_type& fields)
+{
+	const auto field = [&fields](const char* name) -> std::optional<std::string> {
+		const auto value = fields.find(name);
+		return value == fields.end() ? std::nullopt : std::optional<std::string>{ value->second };
+	};
+
+	const auto control = detail::parse_cache_control(field("Cache-Control").value_or(""));
+	if (control.no_store) {
+		return std::nullopt;
+	}
+
+	std::chrono::seconds lifetime{ 0 };
+	if (control.no_cache) {
+		lifetime = std::chrono::seconds{ 0 };
+	} else if (control.max_age.has_value()) {
+		lifetime = *control.max_age;
+	} else if (const auto expires = field("Expires"); expires.has_value()) {
+		const auto expiry = detail::parse_http_date(*expires);
+		const auto date   = detail::parse_http_date(field("Date").value_or("")).value_or(std::time(nullptr));
+		if (expiry.has_value()) {
+			lifetime = std::chrono::seconds{ std::max<std::time_t>(*expiry - date, 0) };
+		}
+	}
+	if (const auto age = field("Age"); age.has_value()) {
+		long seconds = 0;
+		if (std::from_chars(age->data(), age->data() + age->size(), seconds).ec == std::errc{}) {
+			lifetime -= std::chrono::seconds{ seconds };
+		}
+	}
+
+	if (lifetime.count() <= 0 && !field("ETag").has_value() && !field("Last-Modified").has_value()) {
+		return std::nullopt;
+	}
+	return std::chrono::steady_clock::now() + std::max(lifetime, std::chrono::seconds{ 0 });
+}
+
+template<typename Executor>
+inline void BasicCachingSession<Executor>::_insert(std::shared_ptr<Entry> entry)
+{
+	entry->size = entry->body_size + entry->url.size();
+	for (const auto& [key, value] : entry->fields) {
+		entry->size += key.size() + value.size();
+	}
+	if (entry->size > _max_size) {
+		return;
+	}
+
+	CURLIO_DEBUG("Caching " << entry->url << " with " << entry->body_size << " bytes");
+	if (const auto found = _index.find(entry->url); found != _index.end()) {
+		_erase(found->second);
+	}
+	_entries.push_front(entry);
+	_index.emplace(entry->url, _entries.begin());
+	_size += entry->size;
+	while (_size > _max_size) {
+		_erase(std::prev(_entries.end()));
+	}
+	_update_statistics();
+}
+
+template<typename Executor>
+inline void
+  BasicCachingSession<Executor>::_erase(typename std::list<std::shared_ptr<Entry>>::iterator entry) noexcept
+{
+	_size -= (*entry)->size;
+	_index.erase((*entry)->url);
+	_entries.erase(entry);
+}
+
+template<typename Executor>
+inline void BasicCachingSession<Executor>::_update_statistics() noexcept
+{
+	_entry_count.store(_entries.size(), std::memory_order_relaxed);
+	_used_size.store(_size, std::memory_order_relaxed);
+}
+
+} // namespace cURLio
@@ -4,9 +4,17 @@
 #include "detail/asio_include.hpp"
 #include "detail/function.hpp"
 #include "detail/option_type.hpp"
+#include "detail/origin.hpp"
+#include "detail/shared_transfer.hpp"
 #include "fwd.hpp"
+#include "request_pool.hpp"
 
+#include <chrono>
 #include <curl/curl.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
 
 namespace cURLio {
 
@@ -17,20 +25,31 @@ public:
 	using strand_type   = CURLIO_ASIO_NS::strand<executor_type>;
 
 	BasicRequest(BasicSession<Executor>& session);
+	/// Creates a request for the pool. The actual session is chosen when the request is started.
+	BasicRequest(BasicSessionPool<Executor>& pool);
 	BasicRequest(const BasicRequest& copy);
 	BasicRequest(BasicRequest&& move) = delete;
 	~BasicRequest();
 
-	/// Sets cURL option and checks the result.
+	/**
+	 * Sets cURL option and checks the result. The URL and the options which imply the method must be set this
+	 * way instead of on the `native_handle()`. Otherwise the session does not see them, and the host affinity
+	 * of the pool, the resolver, the admission and rate limits per origin, coalescing and caching fall back to
+	 * treating the request as one without URL.
+	 */
 	template<CURLoption Option>
 	void set_option(detail::option_type<Option> value);
 	/// Appends the given header value (e.g. `"User-Agent: me"`) to cURL header list.
 	void append_header(const char* header);
 	/// Frees all headers.
 	void free_headers() noexcept;
+	/// Requests with a higher priority are admitted first if the session limits its transfers (see
+	/// `BasicSession::set_admission_limits()`). The default is zero.
+	void set_priority(int priority) noexcept;
 	/// Sends some of the given buffer (ASIO `ConstBufferSequence`) to the remote.
 	auto async_write_some(const auto& buffers, auto&& token);
 	auto async_abort(auto&& token);
+	/// Options set on the handle directly are not seen by the session (see `set_option()`).
 	CURLIO_NO_DISCARD CURL* native_handle() const noexcept;
 	CURLIO_NO_DISCARD executor_type get_executor() const noexcept;
 	CURLIO_NO_DISCARD strand_type& get_strand() noexcept;
@@ -40,17 +59,52 @@ public:
 
 private:
 	friend class BasicSession<Executor>;
+	friend class BasicSessionPool<Executor>;
+	friend class BasicCachingSession<Executor>;
 	friend class BasicResponse<Executor>;
 
 	std::shared_ptr<strand_type> _strand;
 	// The CURL easy handle. The response owns this instance.
 	CURL* _handle;
 	curl_slist* _additional_headers = nullptr;
+	/// The last URL set with `set_option<CURLOPT_URL>()`.
+	std::string _url{};
+	/// Whether the user set a `CURLOPT_RESOLVE` list. Then the resolver of the session is not used.
+	bool _custom_resolve = false;
+	/// The list handed to cURL by the resolver of the session.
+	curl_slist* _resolve_entries = nullptr;
+	/// The share set with `set_option<CURLOPT_SHARE>()`. Takes precedence over the share of the session.
+	CURLSH* _share = nullptr;
+	/// The pool the handle is returned to. Empty if the handle is freed.
+	std::shared_ptr<RequestPool> _pool{};
 	/// An optional handler waiting to send more data.
 	detail::Function<std::size_t(detail::asio_error_code, char*, std::size_t)> _send_handler{};
+	/// Whether the read callback paused the transfer.
+	bool _paused = false;
+	int _priority = 0;
+	/// Whether the transfer counts against the admission limits of the session.
+	bool _admitted = false;
+	/// The origin the transfer counts against if the session limits the transfers per origin.
+	std::optional<detail::Origin> _origin{};
+	/// The deadline of the current transfer set with `BasicSession::async_start()`.
+	std::optional<std::chrono::steady_clock::time_point> _deadline{};
+	/// The coalesced transfer this request is about to run (see `BasicSession::set_coalescing()`).
+	std::shared_ptr<detail::SharedTransfer> _shared{};
+	/// The method implied by options like `CURLOPT_NOBODY` and the one set with `CURLOPT_CUSTOMREQUEST`.
+	const char* _implied_method = "GET";
+	std::string _custom_method{};
+	/// Whether options like a range, credentials, a time condition or a header list which was not built with
+	/// `append_header()` might make the response specific to this request. Then it is never coalesced.
+	bool _personal = false;
 
 	BasicRequest(std::shared_ptr<BasicSession<Executor>>&& session);
-	void _mark_finished() noexcept;
+	/// Moves this request to the strand of another session. Only allowed if the request is not in use.
+	void _bind(BasicSession<Executor>& session) noexcept;
+	CURLIO_NO_DISCARD std::string_view _method() const noexcept;
+	/// Returns the value of the first header appended with `append_header()` with the given name.
+	CURLIO_NO_DISCARD std::optional<std::string_view> _header(std::string_view name) const noexcept;
+	/// Fails a waiting write with the reason.
+	void _mark_finished(detail::asio_error_code reason) noexcept;
 	static std::size_t _read_callback(char* data, std::size_t size, std::size_t count, void* self_ptr) noexcept;
 };
 
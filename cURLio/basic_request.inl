@@ -2,35 +2,68 @@
 
 #include "basic_request.hpp"
 #include "basic_session.hpp"
+#include "basic_session_pool.hpp"
 #include "debug.hpp"
 #include "error.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
 namespace cURLio {
 
 template<typename Executor>
-inline BasicRequest<Executor>::BasicRequest(BasicSession<Executor>& session) : _strand{ session._strand }
+inline BasicRequest<Executor>::BasicRequest(BasicSession<Executor>& session)
+    : _strand{ session._strand }, _pool{ session._request_pool }
 {
-	_handle = curl_easy_init();
+	_handle = _pool == nullptr ? curl_easy_init() : _pool->acquire();
 
 	CURLIO_EASY_ASSERT(curl_easy_setopt(_handle, CURLOPT_READFUNCTION, &BasicRequest::_read_callback));
 	CURLIO_EASY_ASSERT(curl_easy_setopt(_handle, CURLOPT_READDATA, this));
 }
 
 template<typename Executor>
-inline BasicRequest<Executor>::BasicRequest(const BasicRequest& copy) : _strand{ copy._strand }
+inline BasicRequest<Executor>::BasicRequest(BasicSessionPool<Executor>& pool)
+    : BasicRequest{ pool.get_session(0) }
+{}
+
+template<typename Executor>
+inline BasicRequest<Executor>::BasicRequest(const BasicRequest& copy)
+    : _strand{ copy._strand }, _url{ copy._url }, _custom_resolve{ copy._custom_resolve },
+      _share{ copy._share }, _pool{ copy._pool }, _priority{ copy._priority },
+      _implied_method{ copy._implied_method }, _custom_method{ copy._custom_method },
+      _personal{ copy._personal }
 {
 	_handle = curl_easy_duphandle(copy._handle);
 
 	CURLIO_EASY_ASSERT(curl_easy_setopt(_handle, CURLOPT_READFUNCTION, &BasicRequest::_read_callback));
 	CURLIO_EASY_ASSERT(curl_easy_setopt(_handle, CURLOPT_READDATA, this));
+	// The original might be running with the share of its session.
+	CURLIO_EASY_ASSERT(curl_easy_setopt(_handle, CURLOPT_SHARE, _share));
+	if (!_custom_resolve) {
+		CURLIO_EASY_ASSERT(curl_easy_setopt(_handle, CURLOPT_RESOLVE, nullptr));
+	}
+	// The duplicate only points to the header list of the original.
+	for (auto header = copy._additional_headers; header != nullptr; header = header->next) {
+		_additional_headers = curl_slist_append(_additional_headers, header->data);
+	}
+	if (_additional_headers != nullptr) {
+		CURLIO_EASY_ASSERT(curl_easy_setopt(_handle, CURLOPT_HTTPHEADER, _additional_headers));
+	}
 }
 
 template<typename Executor>
 inline BasicRequest<Executor>::~BasicRequest()
 {
-	CURLIO_DEBUG("Freeing handle @" << _handle);
-	curl_easy_cleanup(_handle);
+	if (_pool == nullptr) {
+		CURLIO_DEBUG("Freeing handle @" << _handle);
+		curl_easy_cleanup(_handle);
+	} else {
+		CURLIO_DEBUG("Returning handle @" << _handle << " to the pool");
+		_pool->release(_handle);
+	}
 	free_headers();
+	curl_slist_free_all(_resolve_entries);
 }
 
 template<typename Executor>
@@ -38,6 +71,40 @@ template<CURLoption Option>
 inline void BasicRequest<Executor>::set_option(detail::option_type<Option> value)
 {
 	CURLIO_EASY_ASSERT(curl_easy_setopt(_handle, Option, value));
+	if constexpr (Option == CURLOPT_URL) {
+		_url = value == nullptr ? "" : value;
+	} else if constexpr (Option == CURLOPT_SHARE) {
+		_share = value;
+	} else if constexpr (Option == CURLOPT_RESOLVE) {
+		_custom_resolve = value != nullptr;
+		curl_slist_free_all(std::exchange(_resolve_entries, nullptr));
+	} else if constexpr (Option == CURLOPT_CUSTOMREQUEST) {
+		_custom_method = value == nullptr ? "" : value;
+	} else if constexpr (Option == CURLOPT_HTTPGET) {
+		if (value) {
+			_implied_method = "GET";
+		}
+	} else if constexpr (Option == CURLOPT_NOBODY) {
+		_implied_method = value ? "HEAD" : "GET";
+	} else if constexpr (Option == CURLOPT_UPLOAD) {
+		_implied_method = value ? "PUT" : "GET";
+	} else if constexpr (Option == CURLOPT_POST) {
+		_implied_method = value ? "POST" : "GET";
+	} else if constexpr (Option == CURLOPT_POSTFIELDS || Option == CURLOPT_COPYPOSTFIELDS ||
+	                     Option == CURLOPT_MIMEPOST) {
+		_implied_method = "POST";
+	} else if constexpr (Option == CURLOPT_RANGE || Option == CURLOPT_USERPWD || Option == CURLOPT_USERNAME ||
+	                     Option == CURLOPT_PASSWORD || Option == CURLOPT_XOAUTH2_BEARER ||
+	                     Option == CURLOPT_COOKIE || Option == CURLOPT_COOKIEFILE ||
+	                     Option == CURLOPT_COOKIELIST) {
+		_personal = _personal || value != nullptr;
+	} else if constexpr (Option == CURLOPT_RESUME_FROM || Option == CURLOPT_RESUME_FROM_LARGE ||
+	                     Option == CURLOPT_NETRC || Option == CURLOPT_TIMECONDITION) {
+		_personal = _personal || value != 0;
+	} else if constexpr (Option == CURLOPT_HTTPHEADER) {
+		// Only the list of `append_header()` can be searched for credentials.
+		_personal = _personal || (value != nullptr && value != _additional_headers);
+	}
 }
 
 template<typename Executor>
@@ -54,6 +121,12 @@ inline void BasicRequest<Executor>::free_headers() noexcept
 	_additional_headers = nullptr;
 }
 
+template<typename Executor>
+inline void BasicRequest<Executor>::set_priority(int priority) noexcept
+{
+	_priority = priority;
+}
+
 template<typename Executor>
 inline auto BasicRequest<Executor>::async_write_some(const auto& buffers, auto&& token)
 {
@@ -86,9 +159,11 @@ inline auto BasicRequest<Executor>::async_write_some(const auto& buffers, auto&&
 				  };
 
 				  // Resume.
-				  if (const auto err = CURLIO_EASY_CHECK(curl_easy_pause(_handle, CURLPAUSE_CONT)); err) {
-					  _send_handler(err, nullptr, 0);
-					  _send_handler.reset();
+				  if (std::exchange(_paused, false)) {
+					  if (const auto err = CURLIO_EASY_CHECK(curl_easy_pause(_handle, CURLPAUSE_CONT)); err) {
+						  _send_handler(err, nullptr, 0);
+						  _send_handler.reset();
+					  }
 				  }
 			  }
 		  });
@@ -125,9 +200,11 @@ inline auto BasicRequest<Executor>::async_abort(auto&& token)
 			  };
 
 			  // Resume.
-			  if (const auto err = CURLIO_EASY_CHECK(curl_easy_pause(_handle, CURLPAUSE_CONT)); err) {
-				  _send_handler(err, nullptr, 0);
-				  _send_handler.reset();
+			  if (std::exchange(_paused, false)) {
+				  if (const auto err = CURLIO_EASY_CHECK(curl_easy_pause(_handle, CURLPAUSE_CONT)); err) {
+					  _send_handler(err, nullptr, 0);
+					  _send_handler.reset();
+				  }
 			  }
 		  });
 	  },
@@ -153,11 +230,38 @@ inline typename BasicRequest<Executor>::strand_type& BasicRequest<Executor>::get
 }
 
 template<typename Executor>
-inline void BasicRequest<Executor>::_mark_finished() noexcept
+inline void BasicRequest<Executor>::_bind(BasicSession<Executor>& session) noexcept
+{
+	_strand = session._strand;
+}
+
+template<typename Executor>
+inline std::string_view BasicRequest<Executor>::_method() const noexcept
+{
+	return _custom_method.empty() ? std::string_view{ _implied_method } : std::string_view{ _custom_method };
+}
+
+template<typename Executor>
+inline std::optional<std::string_view> BasicRequest<Executor>::_header(std::string_view name) const noexcept
+{
+	for (auto header = _additional_headers; header != nullptr; header = header->next) {
+		const std::string_view line{ header->data };
+		if (line.size() > name.size() && line[name.size()] == ':' &&
+		    std::equal(name.begin(), name.end(), line.begin(), [](unsigned char lhs, unsigned char rhs) {
+			    return std::tolower(lhs) == std::tolower(rhs);
+		    })) {
+			return detail::trim(line.substr(name.size() + 1));
+		}
+	}
+	return std::nullopt;
+}
+
+template<typename Executor>
+inline void BasicRequest<Executor>::_mark_finished(detail::asio_error_code reason) noexcept
 {
 	CURLIO_INFO("Request marked as finished");
 	if (_send_handler) {
-		_send_handler(CURLIO_ASIO_NS::error::eof, nullptr, 0);
+		_send_handler(reason, nullptr, 0);
 		_send_handler.reset();
 	}
 }
@@ -180,6 +284,7 @@ inline std::size_t BasicRequest<Executor>::_read_callback(char* data, std::size_
 		return bytes_transferred;
 	}
 
+	self->_paused = true;
 	return CURL_READFUNC_PAUSE;
 }
 
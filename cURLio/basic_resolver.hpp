@@ -0,0 +1,87 @@
+#pragma once
+
+#include "config.hpp"
+#include "detail/asio_include.hpp"
+#include "detail/function.hpp"
+#include "fwd.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cURLio {
+
+/**
+ * Resolves host names with the ASIO resolver and caches the results for a fixed time. A session with a
+ * resolver (see `BasicSession::set_resolver()`) resolves the host of every request before starting it and
+ * hands the addresses to cURL with `CURLOPT_RESOLVE`. Thereby cURL does not need to resolve on its own, which
+ * unless built with c-ares means one thread per lookup. Failed resolutions are not cached and expired hosts
+ * are dropped on the next miss. The resolver can be used by multiple sessions and must outlive them.
+ *
+ * @tparam Executor The ASIO executor type. Most of the time `CURLIO_ASIO_NS::any_io_executor` is enough.
+ */
+template<typename Executor>
+class BasicResolver {
+public:
+	using executor_type = Executor;
+	using strand_type   = CURLIO_ASIO_NS::strand<executor_type>;
+
+	struct Statistics {
+		/// Lookups answered from the cache.
+		std::size_t hits;
+		/// Lookups which had to wait for a resolution.
+		std::size_t misses;
+		/// Resolutions which failed.
+		std::size_t failures;
+	};
+
+	/// @param ttl How long the addresses of a host are used before the host is resolved again.
+	BasicResolver(Executor executor, std::chrono::seconds ttl = std::chrono::seconds{ 60 });
+	BasicResolver(const BasicResolver& copy) = delete;
+	BasicResolver(BasicResolver&& move)      = delete;
+
+	/// Resolves the hosts of the given URLs in the background unless they are already cached. Useful for hot
+	/// origins, so that not even the first request has to wait.
+	void prefetch(const std::vector<std::string>& urls);
+	/// Safe to call from any thread.
+	CURLIO_NO_DISCARD Statistics get_statistics() const noexcept;
+	CURLIO_NO_DISCARD executor_type get_executor() const noexcept;
+
+	BasicResolver& operator=(const BasicResolver& copy) = delete;
+	BasicResolver& operator=(BasicResolver&& move)      = delete;
+
+private:
+	friend class BasicSession<Executor>;
+
+	using handler_type = detail::Function<void(detail::asio_error_code, const std::string&)>;
+
+	struct Entry {
+		/// The addresses in the format of `CURLOPT_RESOLVE`, i.e. `1.2.3.4,[::1]`.
+		std::string addresses;
+		std::chrono::steady_clock::time_point expiry;
+		/// Lookups waiting for the running resolution. Empty if no resolution is running.
+		std::vector<handler_type> waiters;
+	};
+
+	/// Synchronizes the cache and the resolver.
+	strand_type _strand;
+	CURLIO_ASIO_NS::ip::tcp::resolver _resolver{ _strand };
+	std::chrono::seconds _ttl;
+	/// Indexed by `host:port`.
+	std::map<std::string, Entry> _cache{};
+	std::atomic<std::size_t> _hits{ 0 };
+	std::atomic<std::size_t> _misses{ 0 };
+	std::atomic<std::size_t> _failures{ 0 };
+
+	/// Calls the handler with the `CURLOPT_RESOLVE` entry (`host:port:addresses`) of the host. The handler is
+	/// called on the strand of the resolver.
+	void _lookup(std::string host, std::string port, handler_type handler);
+	/// Returns `true` if the host is an IP address and needs no resolution.
+	static bool _is_literal(const std::string& host) noexcept;
+};
+
+using Resolver = BasicResolver<CURLIO_ASIO_NS::any_io_executor>;
+
+} // namespace cURLio
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "basic_resolver.hpp"
+#include "debug.hpp"
+#include "detail/origin.hpp"
+
+#include <utility>
+
+namespace cURLio {
+
+template<typename Executor>
+inline BasicResolver<Executor>::BasicResolver(Executor executor, std::chrono::seconds ttl)
+    : _strand{ CURLIO_ASIO_NS::make_strand(std::move(executor)) }, _ttl{ ttl }
+{}
+
+template<typename Executor>
+inline void BasicResolver<Executor>::prefetch(const std::vector<std::string>& urls)
+{
+	for (const auto& url : urls) {
+		if (const auto origin = detail::parse_origin(url.c_str()); origin && !_is_literal(origin->host)) {
+			_lookup(origin->host, origin->port, [](detail::asio_error_code /* ec */, const std::string& entry) {
+				CURLIO_DEBUG("Prefetched " << entry);
+			});
+		}
+	}
+}
+
+template<typename Executor>
+inline typename BasicResolver<Executor>::Statistics BasicResolver<Executor>::get_statistics() const noexcept
+{
+	return { _hits.load(std::memory_order_relaxed), _misses.load(std::memory_order_relaxed),
+		       _failures.load(std::memory_order_relaxed) };
+}
+
+template<typename Executor>
+inline typename BasicResolver<Executor>::executor_type BasicResolver<Executor>::get_executor() const noexcept
+{
+	return _strand.get_inner_executor();
+}
+
+template<typename Executor>
+inline void BasicResolver<Executor>::_lookup(std::string host, std::string port, handler_type handler)
+{
+	CURLIO_ASIO_NS::dispatch(_strand, [this, host = std::move(host), port = std::move(port),
+	                                   handler = std::move(handler)]() mutable {
+		const auto now = std::chrono::steady_clock::now();
+		auto key       = host + ":" + port;
+		if (const auto cached = _cache.find(key);
+		    cached != _cache.end() && !cached->second.addresses.empty() && cached->second.expiry > now) {
+			_hits.fetch_add(1, std::memory_order_relaxed);
+			handler({}, key + ":" + cached->second.addresses);
+			return;
+		}
+
+		_misses.fetch_add(1, std::memory_order_relaxed);
+		// Misses happen at most once per host and TTL, so sweeping the hosts nobody asks for anymore is cheap.
+		std::erase_if(_cache, [now](const auto& cached) {
+			return cached.second.waiters.empty() && cached.second.expiry <= now;
+		});
+		auto& entry = _cache[key];
+		entry.waiters.push_back(std::move(handler));
+		// Another lookup already started the resolution.
+		if (entry.waiters.size() > 1) {
+			return;
+		}
+
+		CURLIO_DEBUG("Resolving " << key);
+		_resolver.async_resolve(
+		  host, port,
+		  CURLIO_ASIO_NS::bind_executor(
+		    _strand, [this, key = std::move(key)](const detail::asio_error_code& ec,
+		                                          CURLIO_ASIO_NS::ip::tcp::resolver::results_type results) {
+			    auto& entry = _cache[key];
+			    if (ec) {
+				    CURLIO_WARN("Failed to resolve " << key << ": " << ec.message());
+				    _failures.fetch_add(1, std::memory_order_relaxed);
+			    } else {
+				    entry.addresses.clear();
+				    for (const auto& result : results) {
+					    const auto address = result.endpoint().address();
+					    if (!entry.addresses.empty()) {
+						    entry.addresses += ',';
+					    }
+					    entry.addresses += address.is_v6() ? "[" + address.to_string() + "]" : address.to_string();
+				    }
+				    entry.expiry = std::chrono::steady_clock::now() + _ttl;
+			    }
+
+			    auto waiters  = std::exchange(entry.waiters, {});
+			    auto resolved = ec ? std::string{} : key + ":" + entry.addresses;
+			    // Failures are not cached, the next lookup tries again.
+			    if (ec) {
+				    _cache.erase(key);
+			    }
+			    for (auto& waiter : waiters) {
+				    waiter(ec, resolved);
+			    }
+		    }));
+	});
+}
+
+template<typename Executor>
+inline bool BasicResolver<Executor>::_is_literal(const std::string& host) noexcept
+{
+	// IPv6 addresses are enclosed in brackets by the URL API.
+	if (!host.empty() && host.front() == '[') {
+		return true;
+	}
+	detail::asio_error_code ec{};
+	static_cast<void>(CURLIO_ASIO_NS::ip::make_address(host, ec));
+	return !ec;
+}
+
+} // namespace cURLio
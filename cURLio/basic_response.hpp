@@ -2,12 +2,19 @@
 
 #include "config.hpp"
 #include "detail/asio_include.hpp"
+#include "detail/buffer_budget.hpp"
+#include "detail/chunk_pool.hpp"
 #include "detail/function.hpp"
 #include "detail/header_collector.hpp"
+#include "detail/shared_transfer.hpp"
 #include "fwd.hpp"
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <curl/curl.h>
 #include <memory>
+#include <optional>
 
 namespace cURLio {
 
@@ -21,12 +28,45 @@ public:
 
 	BasicResponse(const BasicResponse& copy) = delete;
 	BasicResponse(BasicResponse&& move)      = delete;
+	~BasicResponse();
 
 	/// Returns information about from the easy handle. Access is synchronized.
 	template<CURLINFO Option>
 	auto async_get_info(auto&& token) const;
 	/// Reads some data from the remote and stores it in the given buffer (ASIO `MutableBufferSequence`).
 	auto async_read_some(const auto& buffers, auto&& token);
+	/**
+	 * Like `async_read_some()` but completes with a view (`CURLIO_ASIO_NS::const_buffer`) of the received data
+	 * instead of copying it. The data is not consumed; the view stays valid until `consume()` is called or
+	 * until the next read. Data received from cURL is kept in chunks of 16 KiB, so a view never spans more
+	 * than one of them; buffering ahead (see `set_watermarks()`) only appends behind it. Data of a shared
+	 * transfer (see `BasicSession::set_coalescing()` and `BasicCachingSession`) is viewed in place.
+	 */
+	auto async_read_some_view(auto&& token);
+	/// Consumes `size` bytes from the start of the last view. Must not exceed the size of the view.
+	void consume(std::size_t size);
+	/**
+	 * Hands the body to `sink` on the strand instead of buffering it. Data received from cURL is passed from
+	 * within the write callback, so the response neither copies nor holds it; data which was buffered before
+	 * is passed first. An error of the sink aborts the transfer. The handler signature is
+	 * `void(error_code, std::size_t)` with the bytes taken by the sink. It completes once the transfer is
+	 * finished. No reads may run at the same time.
+	 */
+	auto async_drain(detail::Function<detail::asio_error_code(const char*, std::size_t)> sink, auto&& token);
+	/**
+	 * Lets the response buffer up to `high` bytes ahead of the reads, so that the transfer does not stall
+	 * between them. Once the buffer is full, the transfer is paused until the reads drained it to `low` bytes.
+	 * The buffered bytes count against the budget of the session (see `BasicSession::set_buffer_budget()`).
+	 * With a `high` of zero, the default of the session, the transfer is paused whenever nobody reads.
+	 */
+	void set_watermarks(std::size_t high, std::size_t low);
+	/**
+	 * Lets the response buffer ahead of the reads like `set_watermarks()`, but sizes the high watermark from
+	 * the rate at which the reads drain the buffer: it covers 50 ms of reading, at least 64 KiB and at most
+	 * `limit` bytes. The low watermark is half of it. Small reads thereby no longer pause and resume the
+	 * transfer for every chunk of cURL. A `limit` of zero pauses whenever nobody reads again.
+	 */
+	void set_read_ahead(std::size_t limit);
 	/// Waits until a complete header section is received. This could be the first or the last if this is a
 	/// redirect depending on the settings.
 	auto async_wait_headers(auto&& token);
@@ -39,18 +79,86 @@ public:
 private:
 	// Only the session may construct a response and call `_start()` / `_stop()`.
 	friend class BasicSession<Executor>;
+	friend class BasicCachingSession<Executor>;
 
 	std::shared_ptr<strand_type> _strand;
 	std::shared_ptr<BasicRequest<Executor>> _request;
-	CURLIO_ASIO_NS::streambuf _input_buffer{};
+	/// The received data not taken by a read yet. Its chunks come from the pool of the session.
+	detail::ChunkQueue _input_buffer{};
 	detail::Function<std::size_t(detail::asio_error_code, const char*, std::size_t)> _receive_handler{};
 	detail::HeaderCollector _header_collector;
 	bool _finished = false;
+	/// Reported to reads once the transfer is finished and all data was read.
+	detail::asio_error_code _finish_reason{};
+	/// Whether the write callback paused the transfer. Only then it may be resumed, because cURL refuses to
+	/// resume a transfer which is still waiting for its connection.
+	bool _paused = false;
+	/// The session running this transfer or `nullptr` if the transfer is finished.
+	BasicSession<Executor>* _session = nullptr;
+	/// The index in the active requests of the session.
+	std::size_t _active_index = static_cast<std::size_t>(-1);
+	/// The timer of the deadline in the timer wheel of the session. Zero if the transfer has no deadline.
+	std::uint64_t _deadline_timer = 0;
+	/// The coalesced transfer this response reads from (see `BasicSession::set_coalescing()`).
+	std::shared_ptr<detail::SharedTransfer> _shared{};
+	detail::SharedTransfer::Cursor _cursor{};
+	/// Whether the headers come from the shared transfer instead of cURL.
+	bool _follower = false;
+	/// The number of header sections fed to the collector of a follower.
+	std::size_t _fed_sections = 0;
+	/// Counts the bytes of the input buffer for the session.
+	std::shared_ptr<detail::BufferBudget> _budget{};
+	std::size_t _high_watermark = 0;
+	std::size_t _low_watermark  = 0;
+	/// The upper bound of the adaptive high watermark or zero if the watermarks are fixed.
+	std::size_t _read_ahead_limit = 0;
+	/// The bytes per second taken by the reads as moving average.
+	double _drain_rate = 0;
+	/// The bytes taken by the reads since the start of the measurement.
+	std::size_t _drained = 0;
+	std::chrono::steady_clock::time_point _drain_start{};
+	/// Whether the transfer is paused until the budget has room.
+	bool _budget_waiting = false;
+	struct Sink {
+		detail::Function<detail::asio_error_code(const char*, std::size_t)> function;
+		detail::Function<void(detail::asio_error_code, std::size_t)> handler;
+		/// The bytes taken by the function.
+		std::size_t size = 0;
+		detail::asio_error_code error{};
+	};
+	/// Takes the body while `async_drain()` runs.
+	std::optional<Sink> _sink{};
 
 	BasicResponse(std::shared_ptr<strand_type> strand,
 	              std::shared_ptr<BasicRequest<Executor>> request) noexcept;
 	[[nodiscard]] detail::asio_error_code _start() noexcept;
-	[[nodiscard]] detail::asio_error_code _stop() noexcept;
+	/// Finishes the transfer. Pending and further operations fail with the reason once all data was read.
+	[[nodiscard]] detail::asio_error_code
+	  _stop(detail::asio_error_code reason = CURLIO_ASIO_NS::error::eof) noexcept;
+	/// Reads the body from the shared transfer. A follower also takes its headers from there, otherwise the
+	/// received header sections are added to the transfer.
+	void _subscribe(std::shared_ptr<detail::SharedTransfer> shared, bool follower);
+	/// Hands new data of the shared transfer to a waiting read.
+	void _pump();
+	/// Moves the cursor past data read from the shared transfer.
+	void _advance(std::size_t size);
+	/// Returns the unread data of the first chunk of the input buffer.
+	CURLIO_ASIO_NS::const_buffer _input_view() const noexcept;
+	/// Removes read data from the input buffer and resumes the transfer once the low watermark is reached.
+	void _consume_input(std::size_t size);
+	void _start_read_ahead(std::size_t limit) noexcept;
+	/// Measures the drain rate and adapts the watermarks to it.
+	void _drain(std::size_t size) noexcept;
+	/// Buffers the data if it stays below the high watermark and fits into the budget.
+	bool _read_ahead(const char* data, std::size_t size);
+	void _resume();
+	/// Passes the data to the sink. Returns `false` if the sink failed.
+	bool _feed_sink(const char* data, std::size_t size);
+	/// Completes `async_drain()` with the error of the sink or the reason.
+	void _finish_sink(detail::asio_error_code reason);
+	/// Ends `async_drain()` after the sink failed on data that was already received. Aborts the transfer, or
+	/// stops reading from the shared transfer, and drops the rest of the data.
+	void _fail_sink();
 	static std::size_t _write_callback(char* data, std::size_t size, std::size_t count,
 	                                   void* self_ptr) noexcept;
 };
@@ -5,6 +5,9 @@
 #include "debug.hpp"
 #include "error.hpp"
 
+#include <algorithm>
+#include <utility>
+
 namespace cURLio {
 
 template<typename Executor>
@@ -31,17 +34,23 @@ inline auto BasicResponse<Executor>::async_read_some(const auto& buffers, auto&&
 	  [this](auto handler, const auto& buffers) {
 		  CURLIO_ASIO_NS::dispatch(*_strand, [this, buffers, handler = std::move(handler)]() mutable {
 			  auto executor = CURLIO_ASIO_NS::get_associated_executor(handler, get_executor());
+			  const auto shared_data = _shared ? _shared->peek(_cursor) : std::pair<const char*, std::size_t>{};
 			  // Can immediately finish.
-			  if (_input_buffer.size() > 0) {
-				  const std::size_t copied = CURLIO_ASIO_NS::buffer_copy(buffers, _input_buffer.data());
-				  _input_buffer.consume(copied);
+			  if (shared_data.second > 0) {
+				  const std::size_t copied = CURLIO_ASIO_NS::buffer_copy(
+				    buffers, CURLIO_ASIO_NS::buffer(shared_data.first, shared_data.second));
+				  _advance(copied);
 				  CURLIO_ASIO_NS::post(std::move(executor),
 				                       std::bind(std::move(handler), detail::asio_error_code{}, copied));
-			  } else if (_finished) {
+			  } else if (_input_buffer.size() > 0) {
+				  const std::size_t copied = CURLIO_ASIO_NS::buffer_copy(buffers, _input_buffer.data());
+				  _consume_input(copied);
 				  CURLIO_ASIO_NS::post(std::move(executor),
-				                       std::bind(std::move(handler),
-				                                 detail::asio_error_code{ CURLIO_ASIO_NS::error::eof },
-				                                 std::size_t{ 0 }));
+				                       std::bind(std::move(handler), detail::asio_error_code{}, copied));
+			  } else if (_shared ? _shared->finished() : _finished) {
+				  CURLIO_ASIO_NS::post(
+				    std::move(executor),
+				    std::bind(std::move(handler), _shared ? _shared->reason() : _finish_reason, std::size_t{ 0 }));
 			  } else if (_receive_handler) {
 				  CURLIO_ASIO_NS::post(
 				    std::move(executor),
@@ -67,10 +76,13 @@ inline auto BasicResponse<Executor>::async_read_some(const auto& buffers, auto&&
 				  };
 
 				  // Resume.
-				  if (const auto err = CURLIO_EASY_CHECK(curl_easy_pause(_request->native_handle(), CURLPAUSE_CONT));
-				      err) {
-					  _receive_handler(err, nullptr, 0);
-					  _receive_handler.reset();
+				  if (std::exchange(_paused, false)) {
+					  if (const auto err =
+					        CURLIO_EASY_CHECK(curl_easy_pause(_request->native_handle(), CURLPAUSE_CONT));
+					      err) {
+						  _receive_handler(err, nullptr, 0);
+						  _receive_handler.reset();
+					  }
 				  }
 			  }
 		  });
@@ -78,6 +90,146 @@ inline auto BasicResponse<Executor>::async_read_some(const auto& buffers, auto&&
 	  token, buffers);
 }
 
+template<typename Executor>
+inline auto BasicResponse<Executor>::async_read_some_view(auto&& token)
+{
+	return CURLIO_ASIO_NS::async_initiate<decltype(token),
+	                                      void(detail::asio_error_code, CURLIO_ASIO_NS::const_buffer)>(
+	  [this](auto handler) {
+		  CURLIO_ASIO_NS::dispatch(*_strand, [this, handler = std::move(handler)]() mutable {
+			  auto executor = CURLIO_ASIO_NS::get_associated_executor(handler, get_executor());
+			  const auto shared_data = _shared ? _shared->peek(_cursor) : std::pair<const char*, std::size_t>{};
+			  // Can immediately finish.
+			  if (shared_data.second > 0) {
+				  CURLIO_ASIO_NS::post(std::move(executor),
+				                       std::bind(std::move(handler), detail::asio_error_code{},
+				                                 CURLIO_ASIO_NS::buffer(shared_data.first, shared_data.second)));
+			  } else if (_input_buffer.size() > 0) {
+				  CURLIO_ASIO_NS::post(std::move(executor), std::bind(std::move(handler), detail::asio_error_code{},
+				                                                      _input_view()));
+			  } else if (_shared ? _shared->finished() : _finished) {
+				  CURLIO_ASIO_NS::post(std::move(executor),
+				                       std::bind(std::move(handler), _shared ? _shared->reason() : _finish_reason,
+				                                 CURLIO_ASIO_NS::const_buffer{}));
+			  } else if (_receive_handler) {
+				  CURLIO_ASIO_NS::post(std::move(executor),
+				                       std::bind(std::move(handler), make_error_code(Code::multiple_reads),
+				                                 CURLIO_ASIO_NS::const_buffer{}));
+			  } // Wait for more data.
+			  else {
+#if CURLIO_ASIO_HAS_CANCEL
+				  if (auto slot = boost::asio::get_associated_cancellation_slot(handler); slot.is_connected()) {
+					  slot.assign([this](boost::asio::cancellation_type /* type */) {
+						  _receive_handler(boost::asio::error::operation_aborted, nullptr, 0);
+						  _receive_handler.reset();
+					  });
+				  }
+#endif
+
+				  // Nothing is consumed. The write callback moves the data of cURL into the input buffer after the
+				  // handler returned, hence the view of it is taken afterwards.
+				  _receive_handler = [this, executor = std::move(executor), handler = std::move(handler)](
+				                       detail::asio_error_code ec, const char* data, std::size_t size) mutable {
+					  if (ec || _shared) {
+						  CURLIO_ASIO_NS::post(std::move(executor),
+						                       std::bind(std::move(handler), ec, CURLIO_ASIO_NS::buffer(data, size)));
+					  } else {
+						  CURLIO_ASIO_NS::post(*_strand, [this, executor = std::move(executor),
+						                                  handler  = std::move(handler)]() mutable {
+							  CURLIO_ASIO_NS::post(std::move(executor),
+							                       std::bind(std::move(handler), detail::asio_error_code{}, _input_view()));
+						  });
+					  }
+					  return std::size_t{ 0 };
+				  };
+
+				  // Resume.
+				  if (std::exchange(_paused, false)) {
+					  if (const auto err =
+					        CURLIO_EASY_CHECK(curl_easy_pause(_request->native_handle(), CURLPAUSE_CONT));
+					      err) {
+						  _receive_handler(err, nullptr, 0);
+						  _receive_handler.reset();
+					  }
+				  }
+			  }
+		  });
+	  },
+	  token);
+}
+
+template<typename Executor>
+inline void BasicResponse<Executor>::consume(std::size_t size)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, size] {
+		if (_shared) {
+			_advance(size);
+		} else {
+			_consume_input(size);
+		}
+	});
+}
+
+template<typename Executor>
+inline auto BasicResponse<Executor>::async_drain(
+  detail::Function<detail::asio_error_code(const char*, std::size_t)> sink, auto&& token)
+{
+	return CURLIO_ASIO_NS::async_initiate<decltype(token), void(detail::asio_error_code, std::size_t)>(
+	  [this](auto handler, auto sink) {
+		  CURLIO_ASIO_NS::dispatch(*_strand, [this, sink = std::move(sink),
+		                                      handler = std::move(handler)]() mutable {
+			  auto executor = CURLIO_ASIO_NS::get_associated_executor(handler, get_executor());
+			  if (_receive_handler || _sink) {
+				  CURLIO_ASIO_NS::post(
+				    std::move(executor),
+				    std::bind(std::move(handler), make_error_code(Code::multiple_reads), std::size_t{ 0 }));
+				  return;
+			  }
+
+			  _sink.emplace();
+			  _sink->function = std::move(sink);
+			  _sink->handler  = [executor = std::move(executor), handler = std::move(handler)](
+			                    detail::asio_error_code ec, std::size_t size) mutable {
+				  CURLIO_ASIO_NS::post(std::move(executor), std::bind(std::move(handler), ec, size));
+			  };
+			  if (_shared) {
+				  _pump();
+				  return;
+			  }
+
+			  for (const auto buffer : _input_buffer.data()) {
+				  if (!_feed_sink(static_cast<const char*>(buffer.data()), buffer.size())) {
+					  _fail_sink();
+					  return;
+				  }
+			  }
+			  _consume_input(_input_buffer.size());
+			  if (_finished) {
+				  _finish_sink(_finish_reason);
+			  } else {
+				  _resume();
+			  }
+		  });
+	  },
+	  token, std::move(sink));
+}
+
+template<typename Executor>
+inline void BasicResponse<Executor>::set_watermarks(std::size_t high, std::size_t low)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, high, low] {
+		_high_watermark   = high;
+		_low_watermark    = low;
+		_read_ahead_limit = 0;
+	});
+}
+
+template<typename Executor>
+inline void BasicResponse<Executor>::set_read_ahead(std::size_t limit)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, limit] { _start_read_ahead(limit); });
+}
+
 template<typename Executor>
 inline auto BasicResponse<Executor>::async_wait_headers(auto&& token)
 {
@@ -109,6 +261,18 @@ inline BasicResponse<Executor>::BasicResponse(std::shared_ptr<CURLIO_ASIO_NS::st
       _header_collector{ _request->native_handle() }
 {}
 
+template<typename Executor>
+inline BasicResponse<Executor>::~BasicResponse()
+{
+	if (_budget != nullptr) {
+		_budget->release(_input_buffer.size());
+	}
+	// The transfer might wait for this reader.
+	if (_shared) {
+		_shared->advanced();
+	}
+}
+
 template<typename Executor>
 inline detail::asio_error_code BasicResponse<Executor>::_start() noexcept
 {
@@ -126,7 +290,7 @@ inline detail::asio_error_code BasicResponse<Executor>::_start() noexcept
 }
 
 template<typename Executor>
-inline detail::asio_error_code BasicResponse<Executor>::_stop() noexcept
+inline detail::asio_error_code BasicResponse<Executor>::_stop(detail::asio_error_code reason) noexcept
 {
 	CURLIO_INFO("Response marked as finished");
 
@@ -144,16 +308,263 @@ inline detail::asio_error_code BasicResponse<Executor>::_stop() noexcept
 		return err;
 	}
 
-	_finished = true;
+	_finished      = true;
+	_finish_reason = reason;
+	if (_shared) {
+		_shared->finish(reason);
+	} else if (_sink) {
+		_finish_sink(reason);
+	}
 	if (_receive_handler) {
-		_receive_handler(CURLIO_ASIO_NS::error::eof, nullptr, 0);
+		_receive_handler(reason, nullptr, 0);
 		_receive_handler.reset();
 	}
 
-	_request->_mark_finished();
+	_request->_mark_finished(reason);
 	return {};
 }
 
+template<typename Executor>
+inline void BasicResponse<Executor>::_subscribe(std::shared_ptr<detail::SharedTransfer> shared, bool follower)
+{
+	_shared   = std::move(shared);
+	_cursor   = _shared->begin();
+	_follower = follower;
+	if (!follower) {
+		_header_collector.observe([this](detail::asio_error_code ec, const Headers& fields) {
+			if (!ec) {
+				_shared->add_section(fields);
+			}
+		});
+		// Posted, since resuming might call the write callback right away.
+		_shared->on_drained([strand = _strand, weak = this->weak_from_this()] {
+			CURLIO_ASIO_NS::post(*strand, [weak] {
+				if (const auto self = weak.lock(); self) {
+					self->_resume();
+				}
+			});
+		});
+	}
+	if (follower) {
+		// Shares the ownership of the response, so that the cursor expires with it.
+		_shared->add_reader(
+		  std::shared_ptr<const detail::SharedTransfer::Cursor>{ this->shared_from_this(), &_cursor });
+	}
+	_shared->subscribe([weak = this->weak_from_this()] {
+		// The response might have stopped reading because its sink failed.
+		const auto self = weak.lock();
+		if (self == nullptr || self->_shared == nullptr) {
+			return false;
+		}
+		self->_pump();
+		return self->_shared != nullptr;
+	});
+	_pump();
+}
+
+template<typename Executor>
+inline void BasicResponse<Executor>::_pump()
+{
+	if (_follower) {
+		for (; _fed_sections < _shared->sections().size(); ++_fed_sections) {
+			_header_collector.feed(_shared->sections()[_fed_sections]);
+		}
+		if (_shared->finished() && !_finished) {
+			_finished      = true;
+			_finish_reason = _shared->reason();
+			_header_collector.finish();
+		}
+	}
+
+	if (_sink) {
+		while (true) {
+			const auto [data, size] = _shared->peek(_cursor);
+			if (size == 0) {
+				break;
+			} else if (!_feed_sink(data, size)) {
+				_fail_sink();
+				return;
+			}
+			_advance(size);
+		}
+		if (_shared->finished()) {
+			_finish_sink(_shared->reason());
+		}
+		return;
+	}
+
+	if (!_receive_handler) {
+		return;
+	} else if (const auto [data, size] = _shared->peek(_cursor); size > 0) {
+		const auto taken = _receive_handler({}, data, size);
+		_receive_handler.reset();
+		_advance(taken);
+	} else if (_shared->finished()) {
+		_receive_handler(_shared->reason(), nullptr, 0);
+		_receive_handler.reset();
+	}
+}
+
+template<typename Executor>
+inline void BasicResponse<Executor>::_advance(std::size_t size)
+{
+	_cursor.offset += size;
+	_shared->advanced();
+}
+
+template<typename Executor>
+inline CURLIO_ASIO_NS::const_buffer BasicResponse<Executor>::_input_view() const noexcept
+{
+	return _input_buffer.front();
+}
+
+template<typename Executor>
+inline void BasicResponse<Executor>::_consume_input(std::size_t size)
+{
+	_input_buffer.consume(size);
+	if (_budget != nullptr) {
+		_budget->release(size);
+	}
+	_drain(size);
+	if (_high_watermark > 0 && !_budget_waiting && _input_buffer.size() <= _low_watermark) {
+		_resume();
+	}
+}
+
+template<typename Executor>
+inline void BasicResponse<Executor>::_start_read_ahead(std::size_t limit) noexcept
+{
+	_read_ahead_limit = limit;
+	_high_watermark   = std::min<std::size_t>(limit, 64 * 1024);
+	_low_watermark    = _high_watermark / 2;
+	_drain_rate       = 0;
+	_drained          = 0;
+	_drain_start      = std::chrono::steady_clock::now();
+}
+
+template<typename Executor>
+inline void BasicResponse<Executor>::_drain(std::size_t size) noexcept
+{
+	if (_read_ahead_limit == 0) {
+		return;
+	}
+
+	_drained += size;
+	const auto now                             = std::chrono::steady_clock::now();
+	const std::chrono::duration<double> elapsed = now - _drain_start;
+	// Shorter samples are too noisy.
+	if (elapsed < std::chrono::milliseconds{ 10 }) {
+		return;
+	}
+
+	const double rate = static_cast<double>(_drained) / elapsed.count();
+	_drain_rate       = _drain_rate == 0 ? rate : _drain_rate + (rate - _drain_rate) / 4;
+	_drained          = 0;
+	_drain_start      = now;
+	// Covers 50 ms of reading.
+	const auto window = static_cast<std::size_t>(_drain_rate * 0.05);
+	_high_watermark   = std::min(_read_ahead_limit, std::max<std::size_t>(64 * 1024, window));
+	_low_watermark    = _high_watermark / 2;
+}
+
+template<typename Executor>
+inline bool BasicResponse<Executor>::_read_ahead(const char* data, std::size_t size)
+{
+	if (_input_buffer.size() + size > _high_watermark) {
+		return false;
+	} else if (_budget != nullptr && !_budget->try_acquire(size)) {
+		if (!std::exchange(_budget_waiting, true)) {
+			CURLIO_TRACE("Waiting for the buffer budget with handle @" << _request->_handle);
+			_budget->wait([weak = this->weak_from_this()] {
+				const auto self = weak.lock();
+				if (self == nullptr) {
+					return false;
+				}
+				self->_budget_waiting = false;
+				if (!self->_paused) {
+					return false;
+				}
+				// Might be woken within a cURL callback of another transfer.
+				CURLIO_ASIO_NS::post(*self->_strand, [weak] {
+					if (const auto self = weak.lock(); self != nullptr) {
+						self->_resume();
+					}
+				});
+				return true;
+			});
+		}
+		return false;
+	}
+
+	_input_buffer.append(data, size);
+	return true;
+}
+
+template<typename Executor>
+inline void BasicResponse<Executor>::_resume()
+{
+	if (_session != nullptr && std::exchange(_paused, false)) {
+		CURLIO_TRACE("Resuming handle @" << _request->_handle);
+		CURLIO_EASY_CHECK(curl_easy_pause(_request->native_handle(), CURLPAUSE_CONT));
+	}
+}
+
+template<typename Executor>
+inline bool BasicResponse<Executor>::_feed_sink(const char* data, std::size_t size)
+{
+	if (const auto ec = _sink->function(data, size); ec) {
+		CURLIO_DEBUG("Sink of handle @" << _request->_handle << " failed: " << ec.message());
+		_sink->error = ec;
+		return false;
+	}
+	_sink->size += size;
+	return true;
+}
+
+template<typename Executor>
+inline void BasicResponse<Executor>::_finish_sink(detail::asio_error_code reason)
+{
+	auto sink = std::move(*_sink);
+	_sink.reset();
+	if (sink.error) {
+		reason = sink.error;
+	} else if (reason == CURLIO_ASIO_NS::error::eof) {
+		reason = {};
+	}
+	sink.handler(reason, sink.size);
+}
+
+template<typename Executor>
+inline void BasicResponse<Executor>::_fail_sink()
+{
+	const auto reason = _sink->error;
+	if (_shared) {
+		if (!_finished) {
+			_finished      = true;
+			_finish_reason = reason;
+			_header_collector.finish();
+		}
+		// The transfer must not wait for this response anymore. Released later, since this might be called by
+		// the transfer itself.
+		_cursor = {};
+		_shared->advanced();
+		CURLIO_ASIO_NS::post(*_strand, [shared = std::exchange(_shared, {})] {});
+		_finish_sink({});
+		return;
+	}
+
+	if (_budget != nullptr) {
+		_budget->release(_input_buffer.size());
+	}
+	_input_buffer.consume(_input_buffer.size());
+	if (_session != nullptr) {
+		_session->_unregister(*this, reason);
+	}
+	if (_sink) {
+		_finish_sink({});
+	}
+}
+
 template<typename Executor>
 inline std::size_t BasicResponse<Executor>::_write_callback(char* data, std::size_t size, std::size_t count,
                                                             void* self_ptr) noexcept
@@ -165,6 +576,25 @@ inline std::size_t BasicResponse<Executor>::_write_callback(char* data, std::siz
 		return 0;
 	}
 
+	// The readers take the data from the shared transfer. The slowest of them holds it back.
+	if (self->_shared) {
+		if (!self->_shared->congested()) {
+			self->_shared->append(data, total_length);
+			return total_length;
+		}
+		CURLIO_TRACE("Pausing shared handle @" << self->_request->_handle << " for its slowest reader");
+		self->_paused = true;
+		if (self->_session != nullptr) {
+			self->_session->_pause_count.fetch_add(1, std::memory_order_relaxed);
+		}
+		return CURL_WRITEFUNC_PAUSE;
+	}
+
+	// A failing sink aborts the transfer.
+	if (self->_sink) {
+		return self->_feed_sink(data, total_length) ? total_length : 0;
+	}
+
 	// Someone is waiting for more data.
 	if (self->_receive_handler) {
 		const std::size_t immediately_consumed = self->_receive_handler({}, data, total_length);
@@ -172,21 +602,30 @@ inline std::size_t BasicResponse<Executor>::_write_callback(char* data, std::siz
 		CURLIO_TRACE("Received " << total_length << " bytes and consumed " << immediately_consumed
 		                         << " for handle @" << self->_request->_handle);
 
-		const std::size_t copied = CURLIO_ASIO_NS::buffer_copy(
-		  self->_input_buffer.prepare(total_length - immediately_consumed),
-		  CURLIO_ASIO_NS::buffer(data + immediately_consumed, total_length - immediately_consumed));
-		self->_input_buffer.commit(copied);
+		const std::size_t copied = total_length - immediately_consumed;
+		self->_input_buffer.append(data + immediately_consumed, copied);
+		if (self->_budget != nullptr) {
+			self->_budget->acquire(copied);
+		}
+		self->_drain(immediately_consumed);
 		return immediately_consumed + copied;
+	} else if (self->_read_ahead(data, total_length)) {
+		CURLIO_TRACE("Buffered " << total_length << " bytes ahead for handle @" << self->_request->_handle);
+		return total_length;
 	}
 
 	CURLIO_TRACE("Received " << total_length << " bytes but pausing handle @" << self->_request->_handle);
+	self->_paused = true;
+	if (self->_session != nullptr) {
+		self->_session->_pause_count.fetch_add(1, std::memory_order_relaxed);
+	}
 	return CURL_WRITEFUNC_PAUSE;
 }
 
 template<typename Executor>
 inline auto async_wait_last_headers(std::shared_ptr<BasicResponse<Executor>> response, auto&& token)
 {
-	using headers_type = typename BasicResponse<Executor>::headers_type;
+	using headers_type = Headers;
 	return CURLIO_ASIO_NS::async_compose<decltype(token), void(detail::asio_error_code, headers_type)>(
 	  [response = std::move(response), started = false](auto& self, detail::asio_error_code ec = {},
 	                                                    headers_type headers = {}) mutable {
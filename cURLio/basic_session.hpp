@@ -2,12 +2,32 @@
 
 #include "config.hpp"
 #include "detail/asio_include.hpp"
+#include "detail/buffer_budget.hpp"
+#include "detail/chunk_pool.hpp"
+#include "detail/function.hpp"
+#include "detail/option_type.hpp"
+#include "detail/origin.hpp"
+#include "detail/percentile_window.hpp"
+#include "detail/shared_transfer.hpp"
 #include "detail/socket_data.hpp"
+#include "detail/socket_table.hpp"
+#include "detail/timer_wheel.hpp"
 #include "fwd.hpp"
+#include "request_pool.hpp"
+#include "socket_policy.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <curl/curl.h>
 #include <map>
 #include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace cURLio {
 
@@ -25,15 +45,153 @@ public:
 	using request_pointer  = std::shared_ptr<BasicRequest<Executor>>;
 	using response_pointer = std::shared_ptr<BasicResponse<Executor>>;
 
+	struct AdmissionStatistics {
+		/// Transfers counted against the admission limits.
+		std::size_t running;
+		/// Transfers waiting for admission.
+		std::size_t waiting;
+		/// Transfers which had to wait before they were admitted.
+		std::size_t delayed;
+		/// The summed up waiting time of all delayed transfers.
+		std::chrono::nanoseconds total_wait_time;
+		std::chrono::nanoseconds max_wait_time;
+	};
+	struct HedgeStatistics {
+		/// Copies of requests started by hedged starts.
+		std::size_t fired;
+		/// Hedged starts won by a copy instead of the original request.
+		std::size_t won;
+	};
+
 	BasicSession(Executor executor);
 	BasicSession(const BasicSession& copy) = delete;
 	BasicSession(BasicSession&& move)      = delete;
 	~BasicSession();
 
+	/// Sets an option of the multi handle (e.g. `CURLMOPT_MAX_HOST_CONNECTIONS`) and checks the result. Like
+	/// with requests, this must not be called concurrently with the operations of the session.
+	template<CURLMoption Option>
+	void set_option(detail::multi_option_type<Option> value);
+	/// Attaches all requests started by this session to the share, unless they were attached to a share with
+	/// `set_option<CURLOPT_SHARE>()`. The share must outlive the session.
+	template<typename Mutex>
+	void set_share(BasicShare<Mutex>& share);
+	/// Detaches requests that are started from now on from the share.
+	void set_share(std::nullptr_t);
+	/// Resolves the host of every request with the resolver before starting it, unless the request has its own
+	/// `CURLOPT_RESOLVE` list. The resolver must outlive the session.
+	void set_resolver(BasicResolver<Executor>& resolver);
+	/// Lets cURL resolve the hosts of requests that are started from now on.
+	void set_resolver(std::nullptr_t);
+	/**
+	 * Limits the number of transfers that run at the same time in total and per origin (`scheme://host:port`).
+	 * Zero means no limit, which is the default. Transfers over the limit wait in a queue ordered by the
+	 * priority of their request (see `BasicRequest::set_priority()`) and are started as running transfers
+	 * finish. Transfers which are already running count against the new limits, except for the ones still
+	 * resolving their host.
+	 */
+	void set_admission_limits(std::size_t max_transfers, std::size_t max_transfers_per_origin = 0);
+	/**
+	 * Limits the rate at which transfers to each origin are started with a token bucket. Up to `burst`
+	 * transfers start right away, then `requests_per_second` are started. Transfers over the rate wait in order
+	 * of their start and are subject to the admission limits afterwards. A rate of zero removes the limit.
+	 */
+	void set_rate_limit(double requests_per_second, std::size_t burst = 1);
+	/// Like `set_rate_limit()` above, but only for the origin of the URL. Takes precedence over the limit for
+	/// all origins. Throws `Code::bad_url` if the origin cannot be determined.
+	void set_rate_limit(const std::string& url, double requests_per_second, std::size_t burst = 1);
+	/**
+	 * Lets `async_start()` attach `GET` requests to an identical transfer in flight instead of starting a new
+	 * one. Requests are identical if their URL and the values of the headers named in `key_headers` (as
+	 * appended with `BasicRequest::append_header()`) are equal. All attached responses receive the same header
+	 * sections and the same body, which is kept in memory once for all of them. A transfer stops taking new
+	 * requests once its body exceeds `max_retained` bytes. Attached responses report the information of the
+	 * request running the transfer and other options, the priority and the deadline of the attached requests
+	 * are ignored. Requests with a range, credentials, cookies or a condition (as options or as
+	 * `Authorization`, `Cookie`, `Range`, `If-None-Match`, `If-Modified-Since` or `If-Range` header) or a
+	 * header list which was not built with `append_header()` are never coalesced. A coalesced transfer is
+	 * paused while its slowest response lags more than `max_retained` bytes behind and runs to its end even if
+	 * all its responses are released. Disabled by default.
+	 */
+	void set_coalescing(bool enabled, std::vector<std::string> key_headers = {},
+	                    std::size_t max_retained = 16 * 1024 * 1024);
 	/// Starts the request. If data needs to be sent, this can be done after starting. Otherwise cURL will start
 	/// downloading and pause until the internal buffer is filled. The returned response can be used to read the
-	/// response.
+	/// response. While the request is active, its `CURLOPT_PRIVATE` is used by the session.
 	auto async_start(request_pointer request, auto&& token);
+	/**
+	 * Like `async_start()` but the transfer fails with `timed_out` once the deadline passed. Then the transfer
+	 * is removed from the multi handle right away and pending reads and writes complete with `timed_out`. A
+	 * transfer still waiting for the rate or admission limits fails as soon as its deadline passes.
+	 * Unlike `CURLOPT_TIMEOUT_MS` this does not depend on when cURL checks its timeouts, and all deadlines of
+	 * the session share one timer.
+	 */
+	auto async_start(request_pointer request, std::chrono::steady_clock::time_point deadline, auto&& token);
+	/**
+	 * Like `async_start()` but starts a copy of the request (see the copy constructor of `BasicRequest`) if no
+	 * headers arrived after `hedge_after`, and so on up to `max_hedges` copies. The first transfer that
+	 * receives its headers wins and the others are removed from the multi handle right away. Hence the response
+	 * might belong to a copy. A zero `hedge_after` uses the 95th percentile of the header latencies of earlier
+	 * hedged starts, or 100 ms until enough latencies were measured. Copies are started immediately if all
+	 * running transfers finished without headers. Only use this for idempotent requests without upload data.
+	 */
+	auto async_hedged_start(request_pointer request, std::chrono::milliseconds hedge_after,
+	                        std::size_t max_hedges, auto&& token);
+	/// Fails the start of the request with `operation_aborted` if it still waits for the rate or admission
+	/// limits. Starts which were already admitted are not affected.
+	void abort_waiting(request_pointer request);
+	/**
+	 * Opens connections to the given URLs before traffic arrives, so that the first requests find a connection
+	 * with resolved name and finished TCP and TLS handshakes in the connection cache of cURL. For every URL
+	 * `connections_per_host` concurrent `HEAD` requests are made, hence the URLs should point to a cheap
+	 * resource. cURL only caches 4 connections per transfer by default, so `CURLMOPT_MAXCONNECTS` must be
+	 * raised to warm up more. The handler signature is `void(error_code, std::size_t)` with the number of newly
+	 * opened connections. It only fails if not a single warm-up request succeeded.
+	 */
+	auto async_prewarm(std::vector<std::string> urls, std::size_t connections_per_host, auto&& token);
+	/**
+	 * Keeps at least `idle_connections` connections per URL which are not used by other transfers. This repeats
+	 * the warm-up of `async_prewarm()` every `interval`: idle connections are reused (and thereby not reaped by
+	 * `CURLMOPT_MAXAGE_CONN`) while closed or busy ones are replaced by new connections. Passing zero idle
+	 * connections disables the policy.
+	 */
+	void set_keep_warm(std::vector<std::string> urls, std::size_t idle_connections,
+	                   std::chrono::milliseconds interval = std::chrono::seconds{ 30 });
+	/// Creates the easy handles of new requests from the pool and returns them when the requests are destroyed.
+	/// An empty pointer lets every request create its own handle. Must not be called concurrently with the
+	/// creation of requests.
+	void set_request_pool(std::shared_ptr<RequestPool> pool) noexcept;
+	/**
+	 * Limits the bytes that all responses of this session buffer ahead of their readers. A response which would
+	 * exceed the budget pauses its transfer until other responses are read; paused transfers are resumed in
+	 * the order they paused. A response with a waiting read always receives the next chunk of cURL, hence the
+	 * budget can be exceeded by one chunk per reading response. Unlimited by default.
+	 */
+	void set_buffer_budget(std::size_t budget);
+	/// Sets the default watermarks of new responses (see `BasicResponse::set_watermarks()`).
+	void set_watermarks(std::size_t high, std::size_t low);
+	/// Sets the adaptive read-ahead of new responses (see `BasicResponse::set_read_ahead()`). Replaces the
+	/// watermarks.
+	void set_read_ahead(std::size_t limit);
+	/// Runs the policy (e.g. `socket_policy::low_latency()`) on every socket opened for cURL. An empty policy
+	/// leaves the sockets untouched.
+	void set_socket_policy(SocketPolicy policy);
+	/// Returns the number of transfers that are either starting or running. Safe to call from any thread.
+	CURLIO_NO_DISCARD std::size_t get_active_count() const noexcept;
+	/// Returns the queue depth and waiting times of the admission control. Safe to call from any thread.
+	CURLIO_NO_DISCARD AdmissionStatistics get_admission_statistics() const noexcept;
+	/// Returns the number of starts which were attached to a transfer in flight. Safe to call from any thread.
+	CURLIO_NO_DISCARD std::size_t get_coalesced_count() const noexcept;
+	/// Returns how often hedged starts fired and won. Safe to call from any thread.
+	CURLIO_NO_DISCARD HedgeStatistics get_hedge_statistics() const noexcept;
+	/// Returns the bytes which the responses buffered ahead of their readers. Safe to call from any thread.
+	CURLIO_NO_DISCARD std::size_t get_buffered_size() const noexcept;
+	/// Returns how often responses paused their transfer because nobody read. Every pause costs a resume
+	/// later on. Safe to call from any thread.
+	CURLIO_NO_DISCARD std::size_t get_pause_count() const noexcept;
+	/// If enabled, all sockets that become ready within one turn of the strand are handed to cURL in one batch
+	/// and finished transfers are cleaned once afterwards. Disabled by default.
+	void set_event_coalescing(bool enabled);
 	CURLIO_NO_DISCARD executor_type get_executor() const noexcept;
 	CURLIO_NO_DISCARD strand_type& get_strand() noexcept;
 
@@ -42,19 +200,212 @@ public:
 
 private:
 	friend class BasicRequest<Executor>;
+	friend class BasicResponse<Executor>;
+	friend class BasicCachingSession<Executor>;
 
 	CURLM* _multi_handle;
 	/// Used to synchronize access to cURL (easy and multi).
 	std::shared_ptr<strand_type> _strand;
-	std::map<CURL*, response_pointer> _active_requests{};
+	/// The running transfers. Every response knows its own index and is stored as `CURLOPT_PRIVATE` in its easy
+	/// handle, so no lookup is needed. The responses are owned by the user. Releasing the last reference detaches
+	/// the transfer from the session.
+	std::vector<BasicResponse<Executor>*> _active_requests{};
+	/// Mirrors the active requests including the ones which are about to be started.
+	std::atomic<std::size_t> _active_count{ 0 };
+	/// Set on all started requests without their own share.
+	CURLSH* _share = nullptr;
+	BasicResolver<Executor>* _resolver = nullptr;
+	/// Expires with the session. Completions from outside of the session, like the ones of the resolver, hold a
+	/// weak reference and drop their work once it expired.
+	std::shared_ptr<char> _alive = std::make_shared<char>();
+	SocketPolicy _socket_policy{};
+	std::shared_ptr<RequestPool> _request_pool{};
 	/// All opened sockets by cURL.
-	std::map<curl_socket_t, std::shared_ptr<detail::SocketData>> _sockets{};
+	detail::SocketTable<std::shared_ptr<detail::SocketData>> _sockets{};
 	/// Required to periodically perform the actions from cURL. Controlled by cURL.
 	CURLIO_ASIO_NS::steady_timer _timer{ *_strand };
+	bool _coalesce_events = false;
+	bool _ready_scheduled = false;
+	/// The sockets with ready events which will be handed to cURL in the next batch.
+	std::vector<std::shared_ptr<detail::SocketData>> _ready_sockets{};
+	/// The batch that is currently processed with its events. Kept to reuse its memory.
+	std::vector<std::pair<std::shared_ptr<detail::SocketData>, int>> _processing_sockets{};
+	/// The settings of the keep warm policy. Every change replaces the instance which stops the old cycle.
+	struct KeepWarm {
+		std::vector<std::string> urls;
+		std::size_t idle_connections;
+		std::chrono::milliseconds interval;
+	};
+	std::shared_ptr<KeepWarm> _keep_warm{};
+	CURLIO_ASIO_NS::steady_timer _keep_warm_timer{ *_strand };
+	/// A transfer waiting for admission or for a token of its rate limit.
+	struct Waiting {
+		request_pointer request;
+		std::chrono::steady_clock::time_point since;
+		/// Continues the start or fails it with the given error.
+		detail::Function<void(detail::asio_error_code)> start;
+		/// Fails the start once the deadline of the request passed. Zero if the request has no deadline.
+		std::uint64_t deadline_timer = 0;
+	};
+	/// The state of the admission control. Only the statistics may be accessed outside of the strand.
+	struct Admission {
+		std::size_t max_transfers            = 0;
+		std::size_t max_transfers_per_origin = 0;
+		std::map<detail::Origin, std::size_t> running_per_origin{};
+		/// Ordered by descending priority and then by arrival.
+		std::map<std::pair<int, std::uint64_t>, Waiting> waiting{};
+		std::uint64_t sequence = 0;
+		bool scheduled         = false;
+		std::atomic<std::size_t> running{ 0 };
+		std::atomic<std::size_t> waiting_count{ 0 };
+		std::atomic<std::size_t> delayed{ 0 };
+		std::atomic<std::chrono::nanoseconds::rep> total_wait_time{ 0 };
+		std::atomic<std::chrono::nanoseconds::rep> max_wait_time{ 0 };
+	};
+	Admission _admission{};
+	struct RateLimit {
+		double rate;
+		double burst;
+	};
+	struct Bucket {
+		RateLimit limit;
+		double tokens;
+		std::chrono::steady_clock::time_point refilled;
+		/// Ordered by arrival.
+		std::map<std::uint64_t, Waiting> waiting{};
+		/// The timer which releases the next waiting transfer or, without any, drops the bucket once it is full.
+		/// Zero if none is scheduled.
+		std::uint64_t timer = 0;
+	};
+	/// The token buckets of the rate limits. Only accessed on the strand.
+	struct RateLimiter {
+		std::optional<RateLimit> fallback{};
+		std::map<detail::Origin, RateLimit> limits{};
+		std::map<detail::Origin, Bucket> buckets{};
+		std::uint64_t sequence = 0;
+	};
+	RateLimiter _rate_limiter{};
+	/// Shared by all timed operations of the session so that waiting transfers do not need a timer each.
+	detail::TimerWheel<detail::Function<void()>> _wheel{};
+	CURLIO_ASIO_NS::steady_timer _wheel_timer{ *_strand };
+	bool _wheel_armed = false;
+	/// A hedged start with all of its transfers. Only accessed on the strand.
+	struct Hedge {
+		struct Attempt {
+			request_pointer request;
+			response_pointer response;
+			std::chrono::steady_clock::time_point started;
+		};
+		/// The first attempt runs the original request.
+		std::vector<Attempt> attempts;
+		std::size_t max_hedges;
+		std::chrono::nanoseconds delay;
+		detail::Function<void(detail::asio_error_code, response_pointer)> handler;
+		/// Attempts which neither failed nor finished without headers.
+		std::size_t running = 0;
+		std::uint64_t timer = 0;
+		bool finished       = false;
+	};
+	struct Hedging {
+		/// The header latencies of the winners. Only accessed on the strand.
+		detail::PercentileWindow<std::chrono::nanoseconds, 256> latencies{};
+		std::atomic<std::size_t> fired{ 0 };
+		std::atomic<std::size_t> won{ 0 };
+		/// The hedged starts which are not finished yet. Only accessed on the strand.
+		std::set<std::shared_ptr<Hedge>> pending{};
+	};
+	Hedging _hedging{};
+	struct Coalescing {
+		bool enabled = false;
+		std::vector<std::string> key_headers{};
+		std::size_t max_retained = 0;
+		/// The transfers in flight with the request running them.
+		std::map<std::string, std::pair<std::shared_ptr<detail::SharedTransfer>, request_pointer>> flights{};
+		std::atomic<std::size_t> attached{ 0 };
+	};
+	Coalescing _coalescing{};
+	/// Shared with the responses, which may outlive the session.
+	std::shared_ptr<detail::BufferBudget> _buffer_budget = std::make_shared<detail::BufferBudget>();
+	std::size_t _high_watermark   = 0;
+	std::size_t _low_watermark    = 0;
+	std::size_t _read_ahead_limit = 0;
+	std::atomic<std::size_t> _pause_count{ 0 };
+	/// Hands out the chunks in which the responses buffer their data. Shared with the responses.
+	std::shared_ptr<detail::ChunkPool> _chunk_pool = std::make_shared<detail::ChunkPool>();
 
+	/// Runs the stages of a start on the strand. Only coalesces the start if `coalesce` is set.
+	auto _async_start(request_pointer request, std::optional<std::chrono::steady_clock::time_point> deadline,
+	                  bool coalesce, auto&& token);
+	/// Attaches the start to an identical transfer in flight or starts the request as a new coalesced transfer.
+	/// Returns `false` without touching the handler if the request cannot be coalesced. Runs on the strand.
+	bool _coalesce(request_pointer& request, auto& handler);
+	/// Returns the key of the request or an empty string if it cannot be coalesced.
+	std::string _coalescing_key(const BasicRequest<Executor>& request) const;
+	/// Finishes the shared transfer and removes it from the flights.
+	void _land(detail::SharedTransfer& shared, detail::asio_error_code reason);
+	/// Creates a response which is released on the strand.
+	response_pointer _make_response(request_pointer request);
+	/// Fails the start with the error.
+	void _fail_start(auto handler, detail::asio_error_code ec);
+	/// Delays the request if its origin exceeds its rate limit. Runs on the strand.
+	void _throttle(request_pointer request, auto handler);
+	/// Applies the rate limit to the bucket of the origin and releases its waiting transfers if the limit was
+	/// removed.
+	void _update_bucket(const detail::Origin& origin);
+	static void _refill(Bucket& bucket, std::chrono::steady_clock::time_point now) noexcept;
+	/// Starts the waiting transfers of the bucket as far as its tokens allow.
+	void _drain_bucket(const detail::Origin& origin);
+	/// Calls the callback on the strand once the time has come.
+	std::uint64_t _schedule(std::chrono::steady_clock::time_point expiry, detail::Function<void()> callback);
+	void _arm_wheel();
+	/// Starts the first attempt of a hedged start. Runs on the strand.
+	void _hedged_start(request_pointer request, std::chrono::milliseconds hedge_after, std::size_t max_hedges,
+	                   detail::Function<void(detail::asio_error_code, response_pointer)> handler);
+	void _hedge_attempt(const std::shared_ptr<Hedge>& hedge, request_pointer request);
+	/// Starts a copy of the request and schedules the next one.
+	void _hedge_fire(const std::shared_ptr<Hedge>& hedge);
+	/// Called when the attempt received its headers or finished without them.
+	void _hedge_headers(const std::shared_ptr<Hedge>& hedge, std::size_t index, detail::asio_error_code ec);
+	/// Called when an attempt could not be started.
+	void _hedge_failed(const std::shared_ptr<Hedge>& hedge, detail::asio_error_code ec);
+	/// Removes all other attempts and calls the handler.
+	void _finish_hedge(const std::shared_ptr<Hedge>& hedge, detail::asio_error_code ec,
+	                   response_pointer response);
+	/// Queues the request if the admission limits are reached. Runs on the strand.
+	void _admit(request_pointer request, auto handler);
+	/// Admits waiting transfers as long as the limits allow.
+	void _admit_waiting();
+	/// Whether the limits allow one more transfer of the request.
+	bool _can_admit(const BasicRequest<Executor>& request) const noexcept;
+	/// Counts the transfer of the request against the limits.
+	void _enter(BasicRequest<Executor>& request);
+	/// Stops counting the transfer of the request and schedules the admission of waiting transfers.
+	void _retire(BasicRequest<Executor>& request) noexcept;
+	/// Runs the resolver stage if needed and launches the transfer. Runs on the strand.
+	void _prepare(request_pointer request, auto handler);
+	/// Starts the transfer. Runs on the strand.
+	void _launch(request_pointer request, auto handler);
+	/// Hands the resolved addresses (`host:port:addresses`) to cURL. An empty entry removes them.
+	void _inject_resolve(BasicRequest<Executor>& request, const std::string& entry);
+	/// Runs `connections_per_host` concurrent warm-up requests for each URL. Can be called from any thread.
+	void _prewarm(const std::vector<std::string>& urls, std::size_t connections_per_host,
+	              detail::Function<void(detail::asio_error_code, std::size_t)> handler);
+	/// Runs one warm-up request and reports the number of connections it had to open.
+	void _warm(const std::string& url, detail::Function<void(detail::asio_error_code, long)> handler);
+	void _schedule_keep_warm(const std::shared_ptr<KeepWarm>& keep_warm, std::chrono::milliseconds delay);
 	void _monitor(const std::shared_ptr<detail::SocketData>& data, detail::SocketData::WaitFlag type) noexcept;
+	void _activate(BasicResponse<Executor>& response);
+	void _deactivate(BasicResponse<Executor>& response) noexcept;
+	/// Removes the transfer from the multi handle and finishes the response with the reason.
+	void _unregister(BasicResponse<Executor>& response,
+	                 detail::asio_error_code reason = CURLIO_ASIO_NS::error::eof) noexcept;
 	void _clean_finished() noexcept;
+	/// Called on the strand when the user released the last reference of the response.
+	static void _release(BasicResponse<Executor>* response) noexcept;
 	void _perform(curl_socket_t socket, int bitmask) noexcept;
+	void _socket_action(curl_socket_t socket, int bitmask) noexcept;
+	void _queue_event(const std::shared_ptr<detail::SocketData>& data, detail::SocketData::WaitFlag type);
+	void _perform_ready() noexcept;
 	static int _socket_callback(CURL* easy_handle, curl_socket_t socket, int what, void* self_ptr,
 	                            void* socket_data_ptr) noexcept;
 	static int _timer_callback(CURLM* multi_handle, long timeout_ms, void* self_ptr) noexcept;
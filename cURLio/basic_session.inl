@@ -1,12 +1,17 @@
 #pragma once
 
+#include "basic_request.hpp"
+#include "basic_resolver.hpp"
 #include "basic_response.hpp"
 #include "basic_session.hpp"
+#include "basic_share.hpp"
 #include "debug.hpp"
 #include "detail/final_action.hpp"
+#include "detail/origin.hpp"
 
 #include <functional>
-#include <optional>
+#include <string_view>
+#include <utility>
 
 namespace cURLio {
 
@@ -29,98 +34,1209 @@ template<typename Executor>
 inline BasicSession<Executor>::~BasicSession()
 {
 	_timer.cancel();
+	_keep_warm_timer.cancel();
+	_keep_warm.reset();
 
-	// TODO remove all active easy handles
+	// Landed first, since the responses attached to queued leaders would wait for them forever.
+	for (auto& [key, flight] : std::exchange(_coalescing.flights, {})) {
+		flight.first->finish(CURLIO_ASIO_NS::error::operation_aborted);
+	}
+	// Aborted before the transfers are removed, which would otherwise schedule their admission.
+	for (auto& [key, waiting] : std::exchange(_admission.waiting, {})) {
+		waiting.start(CURLIO_ASIO_NS::error::operation_aborted);
+	}
+	// Finished first, since their transfers would report to them after the session is gone.
+	for (const auto& hedge : std::set<std::shared_ptr<Hedge>>{ _hedging.pending }) {
+		_finish_hedge(hedge, CURLIO_ASIO_NS::error::operation_aborted, {});
+	}
+	// The responses may outlive the session.
+	while (!_active_requests.empty()) {
+		_unregister(*_active_requests.back());
+	}
+	_wheel_timer.cancel();
+	for (auto& [origin, bucket] : std::exchange(_rate_limiter.buckets, {})) {
+		for (auto& [id, waiting] : bucket.waiting) {
+			waiting.start(CURLIO_ASIO_NS::error::operation_aborted);
+		}
+	}
 
 	CURLIO_MULTI_CHECK(curl_multi_cleanup(_multi_handle));
 }
 
+template<typename Executor>
+template<CURLMoption Option>
+inline void BasicSession<Executor>::set_option(detail::multi_option_type<Option> value)
+{
+	CURLIO_MULTI_ASSERT(curl_multi_setopt(_multi_handle, Option, value));
+}
+
+template<typename Executor>
+template<typename Mutex>
+inline void BasicSession<Executor>::set_share(BasicShare<Mutex>& share)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, handle = share.native_handle()] { _share = handle; });
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_share(std::nullptr_t)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this] { _share = nullptr; });
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_resolver(BasicResolver<Executor>& resolver)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, &resolver] { _resolver = &resolver; });
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_resolver(std::nullptr_t)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this] { _resolver = nullptr; });
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_admission_limits(std::size_t max_transfers,
+                                                         std::size_t max_transfers_per_origin)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, max_transfers, max_transfers_per_origin] {
+		_admission.max_transfers            = max_transfers;
+		_admission.max_transfers_per_origin = max_transfers_per_origin;
+		if (max_transfers != 0 || max_transfers_per_origin != 0) {
+			// Transfers which were started without limits count as well.
+			for (const auto response : _active_requests) {
+				auto& request = *response->_request;
+				if (!request._admitted) {
+					request._origin.reset();
+					_enter(request);
+				}
+				if (max_transfers_per_origin != 0 && !request._origin.has_value()) {
+					request._origin = detail::parse_origin(request._url.c_str());
+					if (request._origin.has_value()) {
+						++_admission.running_per_origin[*request._origin];
+					}
+				}
+			}
+		}
+		// The limits might have been raised.
+		_admit_waiting();
+	});
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_rate_limit(double requests_per_second, std::size_t burst)
+{
+	std::optional<RateLimit> limit{};
+	if (requests_per_second > 0) {
+		limit = RateLimit{ requests_per_second, static_cast<double>(std::max<std::size_t>(burst, 1)) };
+	}
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, limit] {
+		_rate_limiter.fallback = limit;
+		std::vector<detail::Origin> origins{};
+		for (const auto& [origin, bucket] : _rate_limiter.buckets) {
+			origins.push_back(origin);
+		}
+		for (const auto& origin : origins) {
+			_update_bucket(origin);
+		}
+	});
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_rate_limit(const std::string& url, double requests_per_second,
+                                                   std::size_t burst)
+{
+	auto origin = detail::parse_origin(url.c_str());
+	if (!origin.has_value()) {
+		throw std::system_error{ Code::bad_url };
+	}
+	std::optional<RateLimit> limit{};
+	if (requests_per_second > 0) {
+		limit = RateLimit{ requests_per_second, static_cast<double>(std::max<std::size_t>(burst, 1)) };
+	}
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, origin = std::move(*origin), limit] {
+		if (limit.has_value()) {
+			_rate_limiter.limits.insert_or_assign(origin, *limit);
+		} else {
+			_rate_limiter.limits.erase(origin);
+		}
+		_update_bucket(origin);
+	});
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_coalescing(bool enabled, std::vector<std::string> key_headers,
+                                                   std::size_t max_retained)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand,
+	                         [this, enabled, key_headers = std::move(key_headers), max_retained]() mutable {
+		                         _coalescing.enabled      = enabled;
+		                         _coalescing.key_headers  = std::move(key_headers);
+		                         _coalescing.max_retained = max_retained;
+		                         // Running transfers continue but take no new requests.
+		                         _coalescing.flights.clear();
+	                         });
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_buffer_budget(std::size_t budget)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, budget] { _buffer_budget->set_limit(budget); });
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_watermarks(std::size_t high, std::size_t low)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, high, low] {
+		_high_watermark   = high;
+		_low_watermark    = low;
+		_read_ahead_limit = 0;
+	});
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_read_ahead(std::size_t limit)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, limit] {
+		_high_watermark   = 0;
+		_low_watermark    = 0;
+		_read_ahead_limit = limit;
+	});
+}
+
 template<typename Executor>
 inline auto BasicSession<Executor>::async_start(request_pointer request, auto&& token)
 {
-	return CURLIO_ASIO_NS::async_initiate<decltype(token),
-	                                      void(detail::asio_error_code, std::shared_ptr<Response>)>(
-	  [this, request = std::move(request)](auto handler) mutable {
+	return _async_start(std::move(request), std::nullopt, true, std::forward<decltype(token)>(token));
+}
+
+template<typename Executor>
+inline auto BasicSession<Executor>::async_start(request_pointer request,
+                                                std::chrono::steady_clock::time_point deadline, auto&& token)
+{
+	return _async_start(std::move(request), deadline, true, std::forward<decltype(token)>(token));
+}
+
+template<typename Executor>
+inline auto BasicSession<Executor>::async_hedged_start(request_pointer request,
+                                                       std::chrono::milliseconds hedge_after,
+                                                       std::size_t max_hedges, auto&& token)
+{
+	return CURLIO_ASIO_NS::async_initiate<decltype(token), void(detail::asio_error_code, response_pointer)>(
+	  [this, request = std::move(request), hedge_after, max_hedges](auto handler) mutable {
+		  auto executor = CURLIO_ASIO_NS::get_associated_executor(handler, get_executor());
 		  CURLIO_ASIO_NS::dispatch(
-		    *_strand, [this, request = std::move(request), handler = std::move(handler)]() mutable {
-			    // If the handle was already registered but the start was too fast, we need to clean it first.
-			    _perform(CURL_SOCKET_TIMEOUT, 0);
-
-			    const auto easy_handle = request->native_handle();
-
-			    // TODO error
-			    request->template set_option<CURLOPT_OPENSOCKETFUNCTION>(&BasicSession::_open_socket_callback);
-			    request->template set_option<CURLOPT_OPENSOCKETDATA>(this);
-			    request->template set_option<CURLOPT_CLOSESOCKETFUNCTION>(&BasicSession::_close_socket_callback);
-			    request->template set_option<CURLOPT_CLOSESOCKETDATA>(this);
-			    auto unregister_request = detail::finally([&] {
-				    request->template set_option<CURLOPT_OPENSOCKETFUNCTION>(nullptr);
-				    request->template set_option<CURLOPT_OPENSOCKETDATA>(nullptr);
-				    request->template set_option<CURLOPT_CLOSESOCKETFUNCTION>(nullptr);
-				    request->template set_option<CURLOPT_CLOSESOCKETDATA>(nullptr);
-			    });
-
-			    // Kick start.
-			    CURLIO_TRACE("Kick-starting handle @" << easy_handle);
-			    auto executor = CURLIO_ASIO_NS::get_associated_executor(handler, get_executor());
-			    if (const auto err = CURLIO_MULTI_CHECK(curl_multi_add_handle(_multi_handle, easy_handle)); err) {
-				    CURLIO_ASIO_NS::post(std::move(executor),
-				                         std::bind(std::move(handler), err, std::shared_ptr<Response>{}));
-				    return;
-			    }
-			    CURLIO_ASIO_NS::post(*_strand, [this] { _perform(CURL_SOCKET_TIMEOUT, 0); });
-
-			    const std::shared_ptr<Response> response{ new Response{ _strand, request } };
-			    if (const auto err = response->_start(); err) {
-				    CURLIO_ASIO_NS::post(std::move(executor),
-				                         std::bind(std::move(handler), err, std::shared_ptr<Response>{}));
-				    return;
-			    }
-			    auto unregister_response = detail::finally([&] {
-				    CURLIO_ERROR("Something prevented lift-off @" << easy_handle);
-				    static_cast<void>(response->_stop());
-				    _active_requests.erase(easy_handle);
-			    });
-			    _active_requests.insert({ easy_handle, response });
-
-			    CURLIO_ASIO_NS::post(std::move(executor),
-			                         std::bind(std::move(handler), detail::asio_error_code{}, response));
-
-			    // Everything went without exceptions.
-			    unregister_response.cancel();
-			    unregister_request.cancel();
+		    *_strand, [this, request = std::move(request), hedge_after, max_hedges,
+		               handler = std::move(handler), executor = std::move(executor)]() mutable {
+			    _hedged_start(std::move(request), hedge_after, max_hedges,
+			                  [handler = std::move(handler), executor = std::move(executor)](
+			                    detail::asio_error_code ec, response_pointer response) mutable {
+				                  CURLIO_ASIO_NS::post(std::move(executor),
+				                                       std::bind(std::move(handler), ec, std::move(response)));
+			                  });
 		    });
 	  },
 	  token);
 }
 
+template<typename Executor>
+inline void BasicSession<Executor>::abort_waiting(request_pointer request)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, request = std::move(request)] {
+		detail::Function<void(detail::asio_error_code)> start{};
+		for (auto it = _admission.waiting.begin(); it != _admission.waiting.end(); ++it) {
+			if (it->second.request == request) {
+				_wheel.cancel(it->second.deadline_timer);
+				start = std::move(it->second.start);
+				_admission.waiting.erase(it);
+				_admission.waiting_count.store(_admission.waiting.size(), std::memory_order_relaxed);
+				break;
+			}
+		}
+		for (auto bucket = _rate_limiter.buckets.begin(); !start && bucket != _rate_limiter.buckets.end();
+		     ++bucket) {
+			for (auto it = bucket->second.waiting.begin(); it != bucket->second.waiting.end(); ++it) {
+				if (it->second.request == request) {
+					_wheel.cancel(it->second.deadline_timer);
+					start = std::move(it->second.start);
+					bucket->second.waiting.erase(it);
+					break;
+				}
+			}
+		}
+		if (start) {
+			CURLIO_INFO("Aborted waiting start of handle @" << request->native_handle());
+			start(CURLIO_ASIO_NS::error::operation_aborted);
+		}
+	});
+}
+
+template<typename Executor>
+inline auto BasicSession<Executor>::async_prewarm(std::vector<std::string> urls,
+                                                  std::size_t connections_per_host, auto&& token)
+{
+	return CURLIO_ASIO_NS::async_initiate<decltype(token), void(detail::asio_error_code, std::size_t)>(
+	  [this, urls = std::move(urls), connections_per_host](auto handler) {
+		  auto executor = CURLIO_ASIO_NS::get_associated_executor(handler, get_executor());
+		  _prewarm(urls, connections_per_host,
+		           [handler = std::move(handler), executor = std::move(executor)](
+		             detail::asio_error_code ec, std::size_t connections) mutable {
+			           CURLIO_ASIO_NS::post(std::move(executor), std::bind(std::move(handler), ec, connections));
+		           });
+	  },
+	  token);
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_keep_warm(std::vector<std::string> urls, std::size_t idle_connections,
+                                                  std::chrono::milliseconds interval)
+{
+	std::shared_ptr<KeepWarm> keep_warm{};
+	if (idle_connections > 0 && !urls.empty()) {
+		keep_warm = std::make_shared<KeepWarm>(KeepWarm{ std::move(urls), idle_connections, interval });
+	}
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, keep_warm = std::move(keep_warm)]() mutable {
+		_keep_warm = std::move(keep_warm);
+		_keep_warm_timer.cancel();
+		if (_keep_warm) {
+			_schedule_keep_warm(_keep_warm, std::chrono::milliseconds{ 0 });
+		}
+	});
+}
+
 template<typename Executor>
 inline typename BasicSession<Executor>::executor_type BasicSession<Executor>::get_executor() const noexcept
 {
 	return _strand->get_inner_executor();
 }
 
+template<typename Executor>
+inline std::size_t BasicSession<Executor>::get_active_count() const noexcept
+{
+	return _active_count.load(std::memory_order_relaxed);
+}
+
+template<typename Executor>
+inline typename BasicSession<Executor>::AdmissionStatistics
+  BasicSession<Executor>::get_admission_statistics() const noexcept
+{
+	return { _admission.running.load(std::memory_order_relaxed),
+		       _admission.waiting_count.load(std::memory_order_relaxed),
+		       _admission.delayed.load(std::memory_order_relaxed),
+		       std::chrono::nanoseconds{ _admission.total_wait_time.load(std::memory_order_relaxed) },
+		       std::chrono::nanoseconds{ _admission.max_wait_time.load(std::memory_order_relaxed) } };
+}
+
+template<typename Executor>
+inline std::size_t BasicSession<Executor>::get_coalesced_count() const noexcept
+{
+	return _coalescing.attached.load(std::memory_order_relaxed);
+}
+
+template<typename Executor>
+inline typename BasicSession<Executor>::HedgeStatistics
+  BasicSession<Executor>::get_hedge_statistics() const noexcept
+{
+	return { _hedging.fired.load(std::memory_order_relaxed), _hedging.won.load(std::memory_order_relaxed) };
+}
+
+template<typename Executor>
+inline std::size_t BasicSession<Executor>::get_buffered_size() const noexcept
+{
+	return _buffer_budget->used();
+}
+
+template<typename Executor>
+inline std::size_t BasicSession<Executor>::get_pause_count() const noexcept
+{
+	return _pause_count.load(std::memory_order_relaxed);
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_event_coalescing(bool enabled)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, enabled] { _coalesce_events = enabled; });
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_request_pool(std::shared_ptr<RequestPool> pool) noexcept
+{
+	_request_pool = std::move(pool);
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::set_socket_policy(SocketPolicy policy)
+{
+	CURLIO_ASIO_NS::dispatch(*_strand, [this, policy = std::move(policy)]() mutable {
+		_socket_policy = std::move(policy);
+	});
+}
+
 template<typename Executor>
 inline typename BasicSession<Executor>::strand_type& BasicSession<Executor>::get_strand() noexcept
 {
 	return *_strand;
 }
 
+template<typename Executor>
+inline auto
+  BasicSession<Executor>::_async_start(request_pointer request,
+                                       std::optional<std::chrono::steady_clock::time_point> deadline,
+                                       bool coalesce, auto&& token)
+{
+	return CURLIO_ASIO_NS::async_initiate<decltype(token), void(detail::asio_error_code, response_pointer)>(
+	  [this, request = std::move(request), deadline, coalesce](auto handler) mutable {
+		  _active_count.fetch_add(1, std::memory_order_relaxed);
+		  CURLIO_ASIO_NS::dispatch(*_strand, [this, request = std::move(request), deadline, coalesce,
+		                                      handler = std::move(handler)]() mutable {
+			  request->_deadline = deadline;
+			  if (request->_url.empty()) {
+				  CURLIO_WARN("Handle @" << request->native_handle()
+				                         << " has no URL set with set_option<CURLOPT_URL>(), origin based "
+				                            "features are skipped");
+			  }
+			  if (!coalesce || !_coalescing.enabled || !_coalesce(request, handler)) {
+				  _throttle(std::move(request), std::move(handler));
+			  }
+		  });
+	  },
+	  token);
+}
+
+template<typename Executor>
+inline bool BasicSession<Executor>::_coalesce(request_pointer& request, auto& handler)
+{
+	auto key = _coalescing_key(*request);
+	if (key.empty()) {
+		return false;
+	}
+
+	auto executor = CURLIO_ASIO_NS::get_associated_executor(handler, get_executor());
+	if (const auto flight = _coalescing.flights.find(key); flight != _coalescing.flights.end()) {
+		if (flight->second.first->joinable()) {
+			CURLIO_DEBUG("Attaching handle @" << request->native_handle() << " to handle @"
+			                                  << flight->second.second->native_handle());
+			_active_count.fetch_sub(1, std::memory_order_relaxed);
+			_coalescing.attached.fetch_add(1, std::memory_order_relaxed);
+			request->_shared.reset();
+			const auto response = _make_response(flight->second.second);
+			response->_subscribe(flight->second.first, true);
+			CURLIO_ASIO_NS::post(std::move(executor),
+			                     std::bind(std::move(handler), detail::asio_error_code{}, response));
+			return true;
+		}
+		_coalescing.flights.erase(flight);
+	}
+
+	const auto shared = std::make_shared<detail::SharedTransfer>(key, _coalescing.max_retained);
+	_coalescing.flights.emplace(std::move(key), std::make_pair(shared, request));
+	request->_shared = shared;
+	// Attached responses must learn if the transfer could not be started.
+	_throttle(std::move(request),
+	          CURLIO_ASIO_NS::bind_executor(
+	            *_strand, [this, alive = std::weak_ptr{ _alive }, shared, executor = std::move(executor),
+	                       handler = std::move(handler)](detail::asio_error_code ec,
+	                                                     response_pointer response) mutable {
+		            // The destructor landed the flight already.
+		            if (ec && !alive.expired()) {
+			            _land(*shared, ec);
+		            }
+		            CURLIO_ASIO_NS::post(std::move(executor),
+		                                 std::bind(std::move(handler), ec, std::move(response)));
+	            }));
+	return true;
+}
+
+template<typename Executor>
+inline std::string BasicSession<Executor>::_coalescing_key(const BasicRequest<Executor>& request) const
+{
+	if (request._method() != "GET" || request._url.empty() || request._personal) {
+		return {};
+	}
+	// Credentials, cookies, ranges and conditions make the response specific to the request.
+	for (const auto name :
+	     { "Authorization", "Cookie", "Range", "If-None-Match", "If-Modified-Since", "If-Range" }) {
+		if (request._header(name).has_value()) {
+			return {};
+		}
+	}
+
+	std::string key = request._url;
+	for (const auto& name : _coalescing.key_headers) {
+		key += '\n';
+		key += name;
+		key += ':';
+		key += request._header(name).value_or(std::string_view{});
+	}
+	return key;
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_land(detail::SharedTransfer& shared, detail::asio_error_code reason)
+{
+	if (const auto flight = _coalescing.flights.find(shared.key());
+	    flight != _coalescing.flights.end() && flight->second.first.get() == &shared) {
+		_coalescing.flights.erase(flight);
+	}
+	shared.finish(reason);
+}
+
+template<typename Executor>
+inline typename BasicSession<Executor>::response_pointer
+  BasicSession<Executor>::_make_response(request_pointer request)
+{
+	response_pointer response{ new BasicResponse<Executor>{ _strand, std::move(request) },
+		                         [strand = _strand](BasicResponse<Executor>* response) {
+			                         if (strand->running_in_this_thread()) {
+				                         _release(response);
+			                         } else {
+				                         CURLIO_ASIO_NS::post(*strand, [response] { _release(response); });
+			                         }
+		                         } };
+	response->_budget         = _buffer_budget;
+	response->_high_watermark = _high_watermark;
+	response->_low_watermark  = _low_watermark;
+	response->_input_buffer   = detail::ChunkQueue{ _chunk_pool };
+	if (_read_ahead_limit > 0) {
+		response->_start_read_ahead(_read_ahead_limit);
+	}
+	return response;
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_fail_start(auto handler, detail::asio_error_code ec)
+{
+	_active_count.fetch_sub(1, std::memory_order_relaxed);
+	auto executor = CURLIO_ASIO_NS::get_associated_executor(handler, get_executor());
+	CURLIO_ASIO_NS::post(std::move(executor), std::bind(std::move(handler), ec, response_pointer{}));
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_throttle(request_pointer request, auto handler)
+{
+	if (!_rate_limiter.fallback.has_value() && _rate_limiter.limits.empty()) {
+		_admit(std::move(request), std::move(handler));
+		return;
+	}
+
+	auto origin = detail::parse_origin(request->_url.c_str());
+	if (!origin.has_value()) {
+		_admit(std::move(request), std::move(handler));
+		return;
+	}
+	auto bucket = _rate_limiter.buckets.find(*origin);
+	if (bucket == _rate_limiter.buckets.end()) {
+		const auto limit = _rate_limiter.limits.find(*origin);
+		if (limit == _rate_limiter.limits.end() && !_rate_limiter.fallback.has_value()) {
+			_admit(std::move(request), std::move(handler));
+			return;
+		}
+		const auto& rate_limit =
+		  limit == _rate_limiter.limits.end() ? *_rate_limiter.fallback : limit->second;
+		bucket = _rate_limiter.buckets
+		           .emplace(*origin, Bucket{ rate_limit, rate_limit.burst, std::chrono::steady_clock::now() })
+		           .first;
+	}
+
+	_refill(bucket->second, std::chrono::steady_clock::now());
+	if (bucket->second.waiting.empty() && bucket->second.tokens >= 1) {
+		bucket->second.tokens -= 1;
+		_drain_bucket(*origin);
+		_admit(std::move(request), std::move(handler));
+		return;
+	}
+
+	const auto id = _rate_limiter.sequence++;
+	Waiting waiting{ request, std::chrono::steady_clock::now(), {} };
+	waiting.start = [this, request, handler = std::move(handler)](detail::asio_error_code ec) mutable {
+		if (ec) {
+			_fail_start(std::move(handler), ec);
+		} else {
+			_admit(std::move(request), std::move(handler));
+		}
+	};
+	if (request->_deadline.has_value()) {
+		waiting.deadline_timer = _schedule(*request->_deadline, [this, origin = *origin, id] {
+			const auto bucket = _rate_limiter.buckets.find(origin);
+			if (bucket == _rate_limiter.buckets.end()) {
+				return;
+			} else if (const auto entry = bucket->second.waiting.find(id); entry != bucket->second.waiting.end()) {
+				CURLIO_INFO("Deadline passed while handle @" << entry->second.request->native_handle()
+				                                             << " waited for its rate limit");
+				auto start = std::move(entry->second.start);
+				bucket->second.waiting.erase(entry);
+				start(CURLIO_ASIO_NS::error::timed_out);
+			}
+		});
+	}
+	bucket->second.waiting.emplace(id, std::move(waiting));
+	_drain_bucket(*origin);
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_update_bucket(const detail::Origin& origin)
+{
+	const auto bucket = _rate_limiter.buckets.find(origin);
+	if (bucket == _rate_limiter.buckets.end()) {
+		return;
+	}
+
+	// The tokens until now are earned with the old limit.
+	_refill(bucket->second, std::chrono::steady_clock::now());
+	if (const auto limit = _rate_limiter.limits.find(origin); limit != _rate_limiter.limits.end()) {
+		bucket->second.limit = limit->second;
+	} else if (_rate_limiter.fallback.has_value()) {
+		bucket->second.limit = *_rate_limiter.fallback;
+	} else {
+		// No limit anymore.
+		auto waiting = std::move(bucket->second.waiting);
+		_wheel.cancel(bucket->second.timer);
+		_rate_limiter.buckets.erase(bucket);
+		for (auto& [id, entry] : waiting) {
+			_wheel.cancel(entry.deadline_timer);
+			entry.start({});
+		}
+		return;
+	}
+
+	bucket->second.tokens = std::min(bucket->second.tokens, bucket->second.limit.burst);
+	_drain_bucket(origin);
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_refill(Bucket& bucket,
+                                            std::chrono::steady_clock::time_point now) noexcept
+{
+	const std::chrono::duration<double> elapsed = now - bucket.refilled;
+	bucket.tokens   = std::min(bucket.limit.burst, bucket.tokens + elapsed.count() * bucket.limit.rate);
+	bucket.refilled = now;
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_drain_bucket(const detail::Origin& origin)
+{
+	const auto bucket = _rate_limiter.buckets.find(origin);
+	if (bucket == _rate_limiter.buckets.end()) {
+		return;
+	}
+
+	const auto now = std::chrono::steady_clock::now();
+	auto& state    = bucket->second;
+	_refill(state, now);
+	// A full bucket without waiters behaves like a new one, so it is dropped instead of keeping every origin.
+	if (state.waiting.empty() && state.tokens >= state.limit.burst) {
+		_wheel.cancel(state.timer);
+		_rate_limiter.buckets.erase(bucket);
+		return;
+	}
+
+	std::vector<detail::Function<void(detail::asio_error_code)>> starts{};
+	while (!state.waiting.empty() && state.tokens >= 1) {
+		state.tokens -= 1;
+		const auto first = state.waiting.begin();
+		_wheel.cancel(first->second.deadline_timer);
+		starts.push_back(std::move(first->second.start));
+		state.waiting.erase(first);
+	}
+
+	// The timer either releases the next waiting transfer or drops the bucket once it is full. A pending timer
+	// of an idle bucket is too late for a new waiter.
+	if (!state.waiting.empty() && state.timer != 0) {
+		_wheel.cancel(std::exchange(state.timer, 0));
+	}
+	if (state.timer == 0) {
+		const auto missing = state.waiting.empty() ? state.limit.burst - state.tokens : 1 - state.tokens;
+		const std::chrono::duration<double> delay{ missing / state.limit.rate };
+		state.timer = _schedule(now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay),
+		                        [this, origin] {
+			                        if (const auto bucket = _rate_limiter.buckets.find(origin);
+			                            bucket != _rate_limiter.buckets.end()) {
+				                        bucket->second.timer = 0;
+				                        _drain_bucket(origin);
+			                        }
+		                        });
+	}
+
+	for (auto& start : starts) {
+		start({});
+	}
+}
+
+template<typename Executor>
+inline std::uint64_t BasicSession<Executor>::_schedule(std::chrono::steady_clock::time_point expiry,
+                                                       detail::Function<void()> callback)
+{
+	const auto id = _wheel.schedule(expiry, std::move(callback));
+	_arm_wheel();
+	return id;
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_arm_wheel()
+{
+	const auto next = _wheel.next_expiry();
+	if (!next.has_value() || (_wheel_armed && _wheel_timer.expiry() <= *next)) {
+		return;
+	}
+
+	_wheel_armed = true;
+	_wheel_timer.expires_at(*next);
+	_wheel_timer.async_wait([this](const detail::asio_error_code& ec) {
+		if (ec) {
+			return;
+		}
+		_wheel_armed = false;
+		std::vector<detail::Function<void()>> expired{};
+		_wheel.advance(std::chrono::steady_clock::now(), expired);
+		for (auto& callback : expired) {
+			callback();
+		}
+		_arm_wheel();
+	});
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_hedged_start(
+  request_pointer request, std::chrono::milliseconds hedge_after, std::size_t max_hedges,
+  detail::Function<void(detail::asio_error_code, response_pointer)> handler)
+{
+	std::chrono::nanoseconds delay = hedge_after;
+	if (delay.count() <= 0) {
+		delay = _hedging.latencies.size() >= 16 ? _hedging.latencies.percentile(0.95)
+		                                        : std::chrono::milliseconds{ 100 };
+	}
+	const auto hedge = std::make_shared<Hedge>(Hedge{ {}, max_hedges, delay, std::move(handler) });
+	_hedging.pending.insert(hedge);
+	_hedge_attempt(hedge, std::move(request));
+	if (max_hedges > 0) {
+		hedge->timer = _schedule(std::chrono::steady_clock::now() + delay, [this, hedge] {
+			hedge->timer = 0;
+			_hedge_fire(hedge);
+		});
+	}
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_hedge_attempt(const std::shared_ptr<Hedge>& hedge,
+                                                   request_pointer request)
+{
+	const std::size_t index = hedge->attempts.size();
+	hedge->attempts.push_back({ request, {}, std::chrono::steady_clock::now() });
+	++hedge->running;
+	_async_start(std::move(request), std::nullopt, false,
+	             CURLIO_ASIO_NS::bind_executor(
+	               *_strand, [this, hedge, index](detail::asio_error_code ec, response_pointer response) {
+		               if (hedge->finished) {
+			               if (response && response->_session != nullptr) {
+				               _unregister(*response, CURLIO_ASIO_NS::error::operation_aborted);
+			               }
+			               return;
+		               } else if (ec) {
+			               _hedge_failed(hedge, ec);
+			               return;
+		               }
+
+		               hedge->attempts[index].response = response;
+		               response->_header_collector.observe(
+		                 [this, hedge, index, observed = false](detail::asio_error_code ec,
+		                                                        const Headers& /* fields */) mutable {
+			                 // Might be called from within a cURL callback where the multi handle must not be used.
+			                 if (!std::exchange(observed, true)) {
+				                 CURLIO_ASIO_NS::post(*_strand,
+				                                      [this, hedge, index, ec] { _hedge_headers(hedge, index, ec); });
+			                 }
+		                 });
+	               }));
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_hedge_fire(const std::shared_ptr<Hedge>& hedge)
+{
+	if (hedge->finished || hedge->attempts.size() > hedge->max_hedges) {
+		return;
+	} else if (hedge->timer != 0) {
+		_wheel.cancel(std::exchange(hedge->timer, 0));
+	}
+
+	const auto& original = *hedge->attempts.front().request;
+	CURLIO_INFO("Hedging handle @" << original.native_handle());
+	request_pointer copy{};
+	try {
+		copy = std::make_shared<BasicRequest<Executor>>(original);
+	} catch (const std::system_error& e) {
+		CURLIO_ERROR("Failed to copy handle @" << original.native_handle() << ": " << e.what());
+		return;
+	}
+	_hedging.fired.fetch_add(1, std::memory_order_relaxed);
+	_hedge_attempt(hedge, std::move(copy));
+
+	if (hedge->attempts.size() <= hedge->max_hedges) {
+		hedge->timer = _schedule(std::chrono::steady_clock::now() + hedge->delay, [this, hedge] {
+			hedge->timer = 0;
+			_hedge_fire(hedge);
+		});
+	}
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_hedge_headers(const std::shared_ptr<Hedge>& hedge, std::size_t index,
+                                                   detail::asio_error_code ec)
+{
+	if (hedge->finished) {
+		return;
+	}
+
+	if (ec) {
+		// Finished without headers. The last attempt is handed to the user like a normal start would be.
+		if (--hedge->running == 0 && hedge->attempts.size() <= hedge->max_hedges) {
+			_hedge_fire(hedge);
+		}
+		if (hedge->running > 0) {
+			hedge->attempts[index].response.reset();
+			return;
+		}
+	} else {
+		_hedging.latencies.add(std::chrono::steady_clock::now() - hedge->attempts[index].started);
+		if (index > 0) {
+			_hedging.won.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	_finish_hedge(hedge, {}, std::move(hedge->attempts[index].response));
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_hedge_failed(const std::shared_ptr<Hedge>& hedge,
+                                                  detail::asio_error_code ec)
+{
+	if (--hedge->running == 0 && hedge->attempts.size() <= hedge->max_hedges) {
+		_hedge_fire(hedge);
+	}
+	// Unless the copy could not be created.
+	if (hedge->running == 0) {
+		_finish_hedge(hedge, ec, {});
+	}
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_finish_hedge(const std::shared_ptr<Hedge>& hedge,
+                                                  detail::asio_error_code ec, response_pointer response)
+{
+	hedge->finished = true;
+	_hedging.pending.erase(hedge);
+	if (hedge->timer != 0) {
+		_wheel.cancel(std::exchange(hedge->timer, 0));
+	}
+	for (auto& attempt : hedge->attempts) {
+		if (!attempt.response) {
+			continue;
+		}
+		attempt.response->_header_collector.unobserve();
+		if (attempt.response->_session != nullptr) {
+			CURLIO_DEBUG("Cancelling hedged handle @" << attempt.request->native_handle());
+			_unregister(*attempt.response, CURLIO_ASIO_NS::error::operation_aborted);
+		}
+	}
+	hedge->attempts.clear();
+	hedge->handler(ec, std::move(response));
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_admit(request_pointer request, auto handler)
+{
+	if (_admission.max_transfers == 0 && _admission.max_transfers_per_origin == 0) {
+		_prepare(std::move(request), std::move(handler));
+		return;
+	}
+
+	if (_admission.max_transfers_per_origin != 0) {
+		request->_origin = detail::parse_origin(request->_url.c_str());
+	} else {
+		request->_origin.reset();
+	}
+
+	if (_admission.waiting.empty() && _can_admit(*request)) {
+		_enter(*request);
+		_prepare(std::move(request), std::move(handler));
+		return;
+	}
+
+	Waiting waiting{ request, std::chrono::steady_clock::now(), {} };
+	waiting.start = [this, request, handler = std::move(handler)](detail::asio_error_code ec) mutable {
+		if (ec) {
+			_fail_start(std::move(handler), ec);
+		} else {
+			_prepare(std::move(request), std::move(handler));
+		}
+	};
+	const auto key = std::make_pair(-request->_priority, _admission.sequence++);
+	if (request->_deadline.has_value()) {
+		waiting.deadline_timer = _schedule(*request->_deadline, [this, key] {
+			if (const auto entry = _admission.waiting.find(key); entry != _admission.waiting.end()) {
+				CURLIO_INFO("Deadline passed while handle @" << entry->second.request->native_handle()
+				                                             << " waited for admission");
+				auto start = std::move(entry->second.start);
+				_admission.waiting.erase(entry);
+				_admission.waiting_count.store(_admission.waiting.size(), std::memory_order_relaxed);
+				start(CURLIO_ASIO_NS::error::timed_out);
+			}
+		});
+	}
+	_admission.waiting.emplace(key, std::move(waiting));
+	_admission.waiting_count.store(_admission.waiting.size(), std::memory_order_relaxed);
+	_admit_waiting();
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_admit_waiting()
+{
+	// Collected first because starting might change the queue.
+	std::vector<detail::Function<void(detail::asio_error_code)>> starts{};
+	const auto now = std::chrono::steady_clock::now();
+	for (auto it = _admission.waiting.begin(); it != _admission.waiting.end();) {
+		// Transfers of a saturated origin let the transfers of other origins pass.
+		if (!_can_admit(*it->second.request)) {
+			if (_admission.max_transfers != 0 &&
+			    _admission.running.load(std::memory_order_relaxed) >= _admission.max_transfers) {
+				break;
+			}
+			++it;
+			continue;
+		}
+		_enter(*it->second.request);
+
+		const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(now - it->second.since).count();
+		_admission.delayed.fetch_add(1, std::memory_order_relaxed);
+		_admission.total_wait_time.fetch_add(waited, std::memory_order_relaxed);
+		if (waited > _admission.max_wait_time.load(std::memory_order_relaxed)) {
+			_admission.max_wait_time.store(waited, std::memory_order_relaxed);
+		}
+
+		_wheel.cancel(it->second.deadline_timer);
+		starts.push_back(std::move(it->second.start));
+		it = _admission.waiting.erase(it);
+	}
+	_admission.waiting_count.store(_admission.waiting.size(), std::memory_order_relaxed);
+
+	for (auto& start : starts) {
+		start({});
+	}
+}
+
+template<typename Executor>
+inline bool BasicSession<Executor>::_can_admit(const BasicRequest<Executor>& request) const noexcept
+{
+	if (_admission.max_transfers != 0 &&
+	    _admission.running.load(std::memory_order_relaxed) >= _admission.max_transfers) {
+		return false;
+	} else if (_admission.max_transfers_per_origin == 0 || !request._origin.has_value()) {
+		return true;
+	}
+	const auto entry = _admission.running_per_origin.find(*request._origin);
+	return entry == _admission.running_per_origin.end() ||
+	       entry->second < _admission.max_transfers_per_origin;
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_enter(BasicRequest<Executor>& request)
+{
+	if (request._origin.has_value()) {
+		++_admission.running_per_origin[*request._origin];
+	}
+	request._admitted = true;
+	_admission.running.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_retire(BasicRequest<Executor>& request) noexcept
+{
+	if (!std::exchange(request._admitted, false)) {
+		return;
+	}
+
+	_admission.running.fetch_sub(1, std::memory_order_relaxed);
+	if (request._origin.has_value()) {
+		if (const auto entry = _admission.running_per_origin.find(*request._origin);
+		    entry != _admission.running_per_origin.end() && --entry->second == 0) {
+			_admission.running_per_origin.erase(entry);
+		}
+	}
+
+	// Not admitted right away, since this might be called while cURL reports finished transfers.
+	if (!_admission.waiting.empty() && !std::exchange(_admission.scheduled, true)) {
+		CURLIO_ASIO_NS::post(*_strand, [this] {
+			_admission.scheduled = false;
+			_admit_waiting();
+		});
+	}
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_prepare(request_pointer request, auto handler)
+{
+	if (_resolver == nullptr || request->_custom_resolve) {
+		_launch(std::move(request), std::move(handler));
+		return;
+	}
+	const auto origin = detail::parse_origin(request->_url.c_str());
+	if (!origin.has_value() || BasicResolver<Executor>::_is_literal(origin->host)) {
+		_launch(std::move(request), std::move(handler));
+		return;
+	}
+
+	_resolver->_lookup(
+	  origin->host, origin->port,
+	  [this, alive = std::weak_ptr{ _alive }, strand = _strand, request = std::move(request),
+	   handler = std::move(handler)](detail::asio_error_code ec, const std::string& entry) mutable {
+		  // Called on the strand of the resolver. On failure cURL resolves on its own.
+		  CURLIO_ASIO_NS::dispatch(*strand, [this, alive = std::move(alive), strand, request = std::move(request),
+		                                     handler = std::move(handler),
+		                                     entry   = ec ? std::string{} : entry]() mutable {
+			  // The session was destroyed during the resolution.
+			  if (alive.expired()) {
+				  auto executor = CURLIO_ASIO_NS::get_associated_executor(handler, strand->get_inner_executor());
+				  const detail::asio_error_code aborted = CURLIO_ASIO_NS::error::operation_aborted;
+				  CURLIO_ASIO_NS::post(std::move(executor),
+				                       std::bind(std::move(handler), aborted, response_pointer{}));
+				  return;
+			  }
+			  _inject_resolve(*request, entry);
+			  _launch(std::move(request), std::move(handler));
+		  });
+	  });
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_launch(request_pointer request, auto handler)
+{
+	if (request->_deadline.has_value() && *request->_deadline <= std::chrono::steady_clock::now()) {
+		CURLIO_INFO("Deadline passed before the start of handle @" << request->native_handle());
+		_retire(*request);
+		_fail_start(std::move(handler), CURLIO_ASIO_NS::error::timed_out);
+		return;
+	}
+
+	// If the handle was already registered but the start was too fast, we need to clean it first.
+	_perform(CURL_SOCKET_TIMEOUT, 0);
+
+	const auto easy_handle = request->native_handle();
+
+	// TODO error
+	request->template set_option<CURLOPT_OPENSOCKETFUNCTION>(&BasicSession::_open_socket_callback);
+	request->template set_option<CURLOPT_OPENSOCKETDATA>(this);
+	request->template set_option<CURLOPT_CLOSESOCKETFUNCTION>(&BasicSession::_close_socket_callback);
+	request->template set_option<CURLOPT_CLOSESOCKETDATA>(this);
+	if (request->_share == nullptr) {
+		CURLIO_EASY_CHECK(curl_easy_setopt(easy_handle, CURLOPT_SHARE, _share));
+	}
+	auto unregister_request = detail::finally([&] {
+		request->template set_option<CURLOPT_OPENSOCKETFUNCTION>(nullptr);
+		request->template set_option<CURLOPT_OPENSOCKETDATA>(nullptr);
+		request->template set_option<CURLOPT_CLOSESOCKETFUNCTION>(nullptr);
+		request->template set_option<CURLOPT_CLOSESOCKETDATA>(nullptr);
+		if (request->_share == nullptr) {
+			CURLIO_EASY_CHECK(curl_easy_setopt(easy_handle, CURLOPT_SHARE, nullptr));
+		}
+	});
+
+	// Kick start.
+	CURLIO_TRACE("Kick-starting handle @" << easy_handle);
+	auto executor = CURLIO_ASIO_NS::get_associated_executor(handler, get_executor());
+	if (const auto err = CURLIO_MULTI_CHECK(curl_multi_add_handle(_multi_handle, easy_handle)); err) {
+		_active_count.fetch_sub(1, std::memory_order_relaxed);
+		_retire(*request);
+		CURLIO_ASIO_NS::post(std::move(executor), std::bind(std::move(handler), err, response_pointer{}));
+		return;
+	}
+	CURLIO_ASIO_NS::post(*_strand, [this] { _perform(CURL_SOCKET_TIMEOUT, 0); });
+
+	const auto response = _make_response(request);
+	if (const auto err = response->_start(); err) {
+		_active_count.fetch_sub(1, std::memory_order_relaxed);
+		_retire(*request);
+		CURLIO_ASIO_NS::post(std::move(executor), std::bind(std::move(handler), err, response_pointer{}));
+		return;
+	}
+	auto unregister_response = detail::finally([&] {
+		CURLIO_ERROR("Something prevented lift-off @" << easy_handle);
+		if (response->_session != nullptr) {
+			_unregister(*response);
+		} else {
+			static_cast<void>(response->_stop());
+			_active_count.fetch_sub(1, std::memory_order_relaxed);
+			_retire(*request);
+		}
+	});
+	_activate(*response);
+	auto reader = response;
+	if (request->_shared) {
+		// Keeps the transfer running for the attached responses. The caller reads through an attached response
+		// as well, so that the transfer only waits for the responses somebody still holds.
+		request->_shared->exchange_owner(response);
+		response->_subscribe(request->_shared, false);
+		reader = _make_response(request);
+		reader->_subscribe(std::exchange(request->_shared, {}), true);
+	}
+	if (request->_deadline.has_value()) {
+		response->_deadline_timer = _schedule(*request->_deadline, [this, response = response.get()] {
+			CURLIO_INFO("Deadline passed for handle @" << response->_request->native_handle());
+			response->_deadline_timer = 0;
+			_unregister(*response, CURLIO_ASIO_NS::error::timed_out);
+		});
+	}
+
+	CURLIO_ASIO_NS::post(std::move(executor),
+	                     std::bind(std::move(handler), detail::asio_error_code{}, std::move(reader)));
+
+	// Everything went without exceptions.
+	unregister_response.cancel();
+	unregister_request.cancel();
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_inject_resolve(BasicRequest<Executor>& request, const std::string& entry)
+{
+	curl_slist_free_all(std::exchange(request._resolve_entries, nullptr));
+	if (!entry.empty()) {
+#if CURL_AT_LEAST_VERSION(7, 75, 0)
+		// Lets the entry time out in the DNS cache of cURL like a normal one.
+		request._resolve_entries = curl_slist_append(nullptr, ("+" + entry).c_str());
+#else
+		request._resolve_entries = curl_slist_append(nullptr, entry.c_str());
+#endif
+	}
+	CURLIO_EASY_CHECK(curl_easy_setopt(request._handle, CURLOPT_RESOLVE, request._resolve_entries));
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_prewarm(
+  const std::vector<std::string>& urls, std::size_t connections_per_host,
+  detail::Function<void(detail::asio_error_code, std::size_t)> handler)
+{
+	struct State {
+		std::size_t pending;
+		std::size_t succeeded;
+		std::size_t connections;
+		detail::asio_error_code ec;
+		detail::Function<void(detail::asio_error_code, std::size_t)> handler;
+	};
+	const auto state =
+	  std::make_shared<State>(State{ urls.size() * connections_per_host, 0, 0, {}, std::move(handler) });
+	if (state->pending == 0) {
+		CURLIO_ASIO_NS::post(*_strand, [state] { state->handler({}, 0); });
+		return;
+	}
+
+	for (const auto& url : urls) {
+		for (std::size_t i = 0; i < connections_per_host; ++i) {
+			_warm(url, [state](detail::asio_error_code ec, long connections) {
+				if (ec) {
+					state->ec = ec;
+				} else {
+					++state->succeeded;
+					state->connections += static_cast<std::size_t>(connections);
+				}
+				if (--state->pending == 0) {
+					CURLIO_INFO("Warmed up " << state->succeeded << " transfers with " << state->connections
+					                         << " new connections");
+					state->handler(state->succeeded > 0 ? detail::asio_error_code{} : state->ec,
+					               state->connections);
+				}
+			});
+		}
+	}
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_warm(const std::string& url,
+                                          detail::Function<void(detail::asio_error_code, long)> handler)
+{
+	auto request = std::make_shared<BasicRequest<Executor>>(*this);
+	request->template set_option<CURLOPT_URL>(url.c_str());
+	request->template set_option<CURLOPT_NOBODY>(1);
+
+	// All handlers are bound to the strand, so the easy handle can be accessed directly.
+	async_start(std::move(request),
+	            CURLIO_ASIO_NS::bind_executor(
+	              *_strand, [strand = _strand, handler = std::move(handler)](
+	                          detail::asio_error_code ec, response_pointer response) mutable {
+		              if (ec) {
+			              handler(ec, 0);
+			              return;
+		              }
+
+		              // Without a body the read completes when the transfer is done and the connection is back in
+		              // the cache.
+		              auto& ref = *response;
+		              ref.async_read_some(
+		                CURLIO_ASIO_NS::mutable_buffer{},
+		                CURLIO_ASIO_NS::bind_executor(
+		                  *strand, [response = std::move(response), handler = std::move(handler)](
+		                             detail::asio_error_code ec, std::size_t /* bytes_transferred */) mutable {
+			                  if (ec && ec != CURLIO_ASIO_NS::error::eof) {
+				                  handler(ec, 0);
+				                  return;
+			                  }
+
+			                  const auto easy_handle = response->_request->native_handle();
+			                  long status            = 0;
+			                  long connections       = 0;
+			                  if (const auto err = CURLIO_EASY_CHECK(
+			                        curl_easy_getinfo(easy_handle, CURLINFO_RESPONSE_CODE, &status));
+			                      err) {
+				                  handler(err, 0);
+			                  } else if (status == 0) {
+				                  // The connection could not be established.
+				                  handler(make_error_code(Code::no_response_code), 0);
+			                  } else {
+				                  const auto err = CURLIO_EASY_CHECK(
+				                    curl_easy_getinfo(easy_handle, CURLINFO_NUM_CONNECTS, &connections));
+				                  handler(err, connections);
+			                  }
+		                  }));
+	              }));
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_schedule_keep_warm(const std::shared_ptr<KeepWarm>& keep_warm,
+                                                        std::chrono::milliseconds delay)
+{
+	_keep_warm_timer.expires_after(delay);
+	_keep_warm_timer.async_wait(
+	  [this, weak = std::weak_ptr<KeepWarm>{ keep_warm }](const detail::asio_error_code& ec) {
+		  const auto keep_warm = weak.lock();
+		  // Either cancelled or replaced by another policy.
+		  if (ec || !keep_warm) {
+			  return;
+		  }
+		  _prewarm(keep_warm->urls, keep_warm->idle_connections,
+		           [this, weak](detail::asio_error_code ec, std::size_t connections) {
+			           CURLIO_DEBUG("Keep warm opened " << connections << " connections ec=" << ec.message());
+			           if (const auto keep_warm = weak.lock(); keep_warm) {
+				           _schedule_keep_warm(keep_warm, keep_warm->interval);
+			           }
+		           });
+	  });
+}
+
 template<typename Executor>
 inline void BasicSession<Executor>::_monitor(const std::shared_ptr<detail::SocketData>& data,
                                              detail::SocketData::WaitFlag type) noexcept
 {
-	CURLIO_TRACE("Monitoring on socket #" << data->socket.native_handle() << " flags=" << data->wait_flags
+	CURLIO_TRACE("Monitoring on socket #" << data->native_handle() << " flags=" << data->wait_flags
 	                                      << " type=" << static_cast<int>(type));
 	if (data->wait_flags & type) {
-		data->socket.async_wait(
+		data->async_wait(
 		  type == detail::SocketData::wait_flag_write ? CURLIO_ASIO_NS::socket_base::wait_write
 		                                              : CURLIO_ASIO_NS::socket_base::wait_read,
 		  [this, type, data](const detail::asio_error_code& ec) {
-			  CURLIO_TRACE("Socket #" << data->socket.native_handle()
+			  CURLIO_TRACE("Socket #" << data->native_handle()
 			                          << " action occurred (flags=" << data->wait_flags << "): " << ec.what());
 			  if (!ec && data->wait_flags & type) {
-				  _perform(data->socket.native_handle(),
+				  if (_coalesce_events) {
+					  _queue_event(data, type);
+					  return;
+				  }
+				  _perform(data->native_handle(),
 				           type == detail::SocketData::wait_flag_write ? CURL_CSELECT_OUT : CURL_CSELECT_IN);
 				  _monitor(data, type);
 			  }
@@ -129,59 +1245,162 @@ inline void BasicSession<Executor>::_monitor(const std::shared_ptr<detail::Socke
 }
 
 template<typename Executor>
-inline void BasicSession<Executor>::_clean_finished() noexcept
+inline void BasicSession<Executor>::_activate(BasicResponse<Executor>& response)
+{
+	CURLIO_ASSERT(response._session == nullptr);
+	_active_requests.push_back(&response);
+	response._session      = this;
+	response._active_index = _active_requests.size() - 1;
+	CURLIO_EASY_CHECK(curl_easy_setopt(response._request->native_handle(), CURLOPT_PRIVATE, &response));
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_deactivate(BasicResponse<Executor>& response) noexcept
 {
-	const auto unregister = [&](typename decltype(_active_requests)::iterator it) {
-		CURLIO_ASSERT(it != _active_requests.end());
+	const std::size_t index = response._active_index;
+	if (response._session != this || index >= _active_requests.size()) {
+		return;
+	}
+	CURLIO_ASSERT(_active_requests[index] == &response);
 
-		CURLIO_MULTI_CHECK(curl_multi_remove_handle(_multi_handle, it->first));
+	CURLIO_EASY_CHECK(curl_easy_setopt(response._request->native_handle(), CURLOPT_PRIVATE, nullptr));
+	response._session      = nullptr;
+	response._active_index = static_cast<std::size_t>(-1);
 
-		CURLIO_EASY_CHECK(curl_easy_setopt(it->first, CURLOPT_OPENSOCKETFUNCTION, nullptr));
-		CURLIO_EASY_CHECK(curl_easy_setopt(it->first, CURLOPT_OPENSOCKETDATA, nullptr));
-		CURLIO_EASY_CHECK(curl_easy_setopt(it->first, CURLOPT_CLOSESOCKETFUNCTION, nullptr));
-		CURLIO_EASY_CHECK(curl_easy_setopt(it->first, CURLOPT_CLOSESOCKETDATA, nullptr));
+	// Swap with the last one.
+	_active_requests[index]                = _active_requests.back();
+	_active_requests[index]->_active_index = index;
+	_active_requests.pop_back();
+}
 
-		static_cast<void>(it->second->_stop());
-		return _active_requests.erase(it);
-	};
+template<typename Executor>
+inline void BasicSession<Executor>::_unregister(BasicResponse<Executor>& response,
+                                                detail::asio_error_code reason) noexcept
+{
+	if (response._deadline_timer != 0) {
+		_wheel.cancel(std::exchange(response._deadline_timer, 0));
+	}
+
+	const auto easy_handle = response._request->native_handle();
+	CURLIO_MULTI_CHECK(curl_multi_remove_handle(_multi_handle, easy_handle));
+
+	CURLIO_EASY_CHECK(curl_easy_setopt(easy_handle, CURLOPT_OPENSOCKETFUNCTION, nullptr));
+	CURLIO_EASY_CHECK(curl_easy_setopt(easy_handle, CURLOPT_OPENSOCKETDATA, nullptr));
+	CURLIO_EASY_CHECK(curl_easy_setopt(easy_handle, CURLOPT_CLOSESOCKETFUNCTION, nullptr));
+	CURLIO_EASY_CHECK(curl_easy_setopt(easy_handle, CURLOPT_CLOSESOCKETDATA, nullptr));
+	if (response._request->_share == nullptr) {
+		CURLIO_EASY_CHECK(curl_easy_setopt(easy_handle, CURLOPT_SHARE, nullptr));
+	}
+	if (response._request->_resolve_entries != nullptr) {
+		_inject_resolve(*response._request, {});
+	}
+
+	static_cast<void>(response._stop(reason));
+	_active_count.fetch_sub(1, std::memory_order_relaxed);
+	_retire(*response._request);
+	_deactivate(response);
+	if (response._shared) {
+		_land(*response._shared, reason);
+		// Released later, since this might be the last reference to the response.
+		if (auto owner = response._shared->exchange_owner({}); owner) {
+			CURLIO_ASIO_NS::post(*_strand, [owner = std::move(owner)] {});
+		}
+	}
+}
 
-	const std::size_t active_count = _active_requests.size();
-	CURLMsg* message               = nullptr;
-	int left                       = 0;
+template<typename Executor>
+inline void BasicSession<Executor>::_clean_finished() noexcept
+{
+	CURLMsg* message = nullptr;
+	int left         = 0;
 	while ((message = curl_multi_info_read(_multi_handle, &left))) {
 		if (message->msg == CURLMSG_DONE) {
 			CURLIO_INFO("Removing handle @" << message->easy_handle);
-			unregister(_active_requests.find(message->easy_handle));
+			char* response = nullptr;
+			CURLIO_EASY_CHECK(curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &response));
+			if (response != nullptr) {
+				_unregister(*reinterpret_cast<BasicResponse<Executor>*>(response));
+			} else {
+				CURLIO_WARN("Handle @" << message->easy_handle << " is not active");
+			}
 		} else {
 			CURLIO_WARN("Got unknown message '" << message->msg << "' during cleaning for @"
 			                                    << message->easy_handle);
 		}
 	}
+}
 
-	// Unregister all active request that have no other owner.
-	for (auto it = _active_requests.begin(); it != _active_requests.end();) {
-		if (it->second.use_count() == 1) {
-			CURLIO_INFO("Stale handle @" << it->first << " found in active requests");
-			it = unregister(it);
-		} else {
-			++it;
-		}
-	}
-
-	if (active_count != _active_requests.size()) {
-		CURLIO_INFO("Cleaned " << active_count - _active_requests.size() << " handles and left with "
-		                       << _active_requests.size() << " active ones");
+template<typename Executor>
+inline void BasicSession<Executor>::_release(BasicResponse<Executor>* response) noexcept
+{
+	if (response->_session != nullptr) {
+		CURLIO_INFO("Detaching abandoned handle @" << response->_request->native_handle());
+		response->_session->_unregister(*response);
 	}
+	delete response;
 }
 
 template<typename Executor>
 inline void BasicSession<Executor>::_perform(curl_socket_t socket, int bitmask) noexcept
+{
+	_socket_action(socket, bitmask);
+	_clean_finished();
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_socket_action(curl_socket_t socket, int bitmask) noexcept
 {
 	int running = 0;
 	CURLIO_MULTI_CHECK(curl_multi_socket_action(_multi_handle, socket, bitmask, &running));
 	CURLIO_TRACE("Action performed for socket #" << socket << " with bitmask " << bitmask
 	                                             << " and running handles " << running);
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_queue_event(const std::shared_ptr<detail::SocketData>& data,
+                                                 detail::SocketData::WaitFlag type)
+{
+	if (data->ready_events == 0) {
+		_ready_sockets.push_back(data);
+	}
+	data->ready_events |= type == detail::SocketData::wait_flag_write ? CURL_CSELECT_OUT : CURL_CSELECT_IN;
+
+	// The first event of this turn schedules the batch behind all events that are already queued.
+	if (!_ready_scheduled) {
+		_ready_scheduled = true;
+		CURLIO_ASIO_NS::post(*_strand, [this] { _perform_ready(); });
+	}
+}
+
+template<typename Executor>
+inline void BasicSession<Executor>::_perform_ready() noexcept
+{
+	_ready_scheduled = false;
+	CURLIO_TRACE("Performing batch of " << _ready_sockets.size() << " ready sockets");
+
+	for (auto& data : _ready_sockets) {
+		const int events = std::exchange(data->ready_events, 0);
+		// The socket might have been closed by an earlier action of this batch.
+		if (data->is_open()) {
+			_socket_action(data->native_handle(), events);
+		}
+		_processing_sockets.emplace_back(std::move(data), events);
+	}
+	_ready_sockets.clear();
+
 	_clean_finished();
+
+	for (const auto& [data, events] : _processing_sockets) {
+		if (data->is_open()) {
+			if (events & CURL_CSELECT_IN) {
+				_monitor(data, detail::SocketData::wait_flag_read);
+			}
+			if (events & CURL_CSELECT_OUT) {
+				_monitor(data, detail::SocketData::wait_flag_write);
+			}
+		}
+	}
+	_processing_sockets.clear();
 }
 
 template<typename Executor>
@@ -194,17 +1413,17 @@ inline int BasicSession<Executor>::_socket_callback(CURL* easy_handle, curl_sock
 
 	const auto self = static_cast<BasicSession*>(self_ptr);
 
-	const auto it = self->_sockets.find(socket);
-	if (it == self->_sockets.end()) {
+	const auto entry = self->_sockets.find(socket);
+	if (entry == nullptr) {
 		CURLIO_WARN("Socket #" << socket << " in handle @" << easy_handle << " was not found");
 		return CURLM_OK;
 	}
 
-	const auto& data = it->second;
+	const auto& data = *entry;
 	data->wait_flags = 0;
 
 	if (what == CURL_POLL_REMOVE) {
-		data->socket.cancel();
+		data->cancel();
 		return CURLM_OK;
 	}
 
@@ -254,23 +1473,32 @@ inline curl_socket_t BasicSession<Executor>::_open_socket_callback(void* self_pt
 	CURLIO_TRACE("Trying to open new socket with family=" << address->family << " purpose=" << purpose);
 	const auto self = static_cast<BasicSession*>(self_ptr);
 
-	std::optional<CURLIO_ASIO_NS::ip::tcp> protocol{};
-	if (address->family == AF_INET) {
-		protocol = CURLIO_ASIO_NS::ip::tcp::v4();
-	} else if (address->family == AF_INET6) {
-		protocol = CURLIO_ASIO_NS::ip::tcp::v6();
+	detail::asio_error_code ec{};
+	std::shared_ptr<detail::SocketData> data{};
+	if (address->family == AF_INET || address->family == AF_INET6) {
+		CURLIO_ASIO_NS::ip::tcp::socket socket{ self->get_strand() };
+		static_cast<void>(socket.open(
+		  address->family == AF_INET ? CURLIO_ASIO_NS::ip::tcp::v4() : CURLIO_ASIO_NS::ip::tcp::v6(), ec));
+		if (!ec && self->_socket_policy) {
+			self->_socket_policy(socket);
+		}
+		data = std::make_shared<detail::SocketData>(std::move(socket));
 	}
+#if CURLIO_ASIO_HAS_LOCAL_SOCKETS
+	else if (address->family == AF_UNIX) {
+		// Requested by `CURLOPT_UNIX_SOCKET_PATH` and `CURLOPT_ABSTRACT_UNIX_SOCKET`. Socket policies only
+		// apply to TCP.
+		CURLIO_ASIO_NS::local::stream_protocol::socket socket{ self->get_strand() };
+		static_cast<void>(socket.open(CURLIO_ASIO_NS::local::stream_protocol{}, ec));
+		data = std::make_shared<detail::SocketData>(std::move(socket));
+	}
+#endif
 
-	if (protocol.has_value()) {
-		detail::asio_error_code ec{};
-		auto data = std::make_shared<detail::SocketData>(CURLIO_ASIO_NS::ip::tcp::socket{ self->get_strand() });
-		static_cast<void>(data->socket.open(protocol.value(), ec));
-		if (!ec) {
-			const auto fd = data->socket.native_handle();
-			CURLIO_INFO("New socket #" << fd << " opened");
-			self->_sockets.insert({ fd, std::move(data) });
-			return fd;
-		}
+	if (data != nullptr && !ec) {
+		const auto fd = data->native_handle();
+		CURLIO_INFO("New socket #" << fd << " opened");
+		self->_sockets.insert(fd, std::move(data));
+		return fd;
 	}
 
 	CURLIO_ERROR("Failed to open socket");
@@ -283,10 +1511,9 @@ inline int BasicSession<Executor>::_close_socket_callback(void* self_ptr, curl_s
 	const auto self = static_cast<BasicSession*>(self_ptr);
 
 	CURLIO_INFO("Closing socket #" << socket);
-	if (const auto it = self->_sockets.find(socket); it != self->_sockets.end()) {
+	if (const auto data = self->_sockets.erase(socket); data) {
 		detail::asio_error_code ec{};
-		it->second->socket.close(ec);
-		self->_sockets.erase(it);
+		data->close(ec);
 		if (ec) {
 			return CURLE_UNKNOWN_OPTION;
 		}
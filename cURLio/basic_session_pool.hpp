@@ -0,0 +1,78 @@
+#pragma once
+
+#include "basic_session.hpp"
+#include "config.hpp"
+#include "detail/asio_include.hpp"
+#include "fwd.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace cURLio {
+
+/**
+ * Owns multiple sessions, each with its own `CURLM` handle, strand and sockets, and spreads the transfers
+ * over them. Since every session is synchronized by its own strand, the transfers can be processed by as
+ * many threads as there are sessions.
+ *
+ * @tparam Executor The ASIO executor type. Most of the time `CURLIO_ASIO_NS::any_io_executor` is enough.
+ */
+template<typename Executor>
+class BasicSessionPool {
+public:
+	using executor_type    = Executor;
+	using session_type     = BasicSession<Executor>;
+	using request_pointer  = typename session_type::request_pointer;
+	using response_pointer = typename session_type::response_pointer;
+
+	/// How a session is chosen when starting a request.
+	enum class Placement {
+		/// The session with the least starting and running transfers.
+		least_active,
+		/// All requests to the same origin (scheme, host and port) go to the same session. This keeps the
+		/// connection reuse of cURL intact. Requests without a known URL fall back to `least_active`.
+		host_affinity,
+	};
+
+	/// Creates one session per executor. Ideally every executor is run by its own thread.
+	BasicSessionPool(const std::vector<Executor>& executors, Placement placement = Placement::least_active);
+	/// Creates `count` sessions on the same executor. Useful if the executor is run by multiple threads.
+	BasicSessionPool(Executor executor, std::size_t count, Placement placement = Placement::least_active);
+	BasicSessionPool(const BasicSessionPool& copy) = delete;
+	BasicSessionPool(BasicSessionPool&& move)      = delete;
+	~BasicSessionPool()                            = default;
+
+	/// Chooses a session and starts the request there. The request must not be in use, because it will be
+	/// bound to the strand of the chosen session.
+	auto async_start(request_pointer request, auto&& token);
+	/// Attaches all sessions to the share, so that they resolve and handshake a host only once.
+	template<typename Mutex>
+	void set_share(BasicShare<Mutex>& share);
+	/// Lets all sessions resolve their hosts with the resolver.
+	void set_resolver(BasicResolver<Executor>& resolver);
+	/// Sets the socket policy of all sessions.
+	void set_socket_policy(const SocketPolicy& policy);
+	/// Sets the admission limits of every session. They apply to each session on its own.
+	void set_admission_limits(std::size_t max_transfers, std::size_t max_transfers_per_origin = 0);
+	/// Lets all sessions share the request pool.
+	void set_request_pool(const std::shared_ptr<RequestPool>& pool) noexcept;
+	CURLIO_NO_DISCARD std::size_t size() const noexcept;
+	CURLIO_NO_DISCARD session_type& get_session(std::size_t index) noexcept;
+	CURLIO_NO_DISCARD Placement get_placement() const noexcept;
+
+	BasicSessionPool& operator=(const BasicSessionPool& copy) = delete;
+	BasicSessionPool& operator=(BasicSessionPool&& move)      = delete;
+
+private:
+	std::vector<std::unique_ptr<session_type>> _sessions{};
+	Placement _placement;
+	/// Rotates the starting point when searching the least active session so that ties are distributed.
+	std::atomic<std::size_t> _next{ 0 };
+
+	session_type& _select(const BasicRequest<Executor>& request) noexcept;
+};
+
+using SessionPool = BasicSessionPool<CURLIO_ASIO_NS::any_io_executor>;
+
+} // namespace cURLio
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "basic_request.hpp"
+#include "basic_session.inl"
+#include "basic_session_pool.hpp"
+#include "debug.hpp"
+#include "detail/origin.hpp"
+
+#include <functional>
+#include <limits>
+
+namespace cURLio {
+
+template<typename Executor>
+inline BasicSessionPool<Executor>::BasicSessionPool(const std::vector<Executor>& executors, Placement placement)
+    : _placement{ placement }
+{
+	CURLIO_ASSERT(!executors.empty());
+	_sessions.reserve(executors.size());
+	for (const auto& executor : executors) {
+		_sessions.push_back(std::make_unique<session_type>(executor));
+	}
+}
+
+template<typename Executor>
+inline BasicSessionPool<Executor>::BasicSessionPool(Executor executor, std::size_t count, Placement placement)
+    : _placement{ placement }
+{
+	CURLIO_ASSERT(count > 0);
+	_sessions.reserve(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		_sessions.push_back(std::make_unique<session_type>(executor));
+	}
+}
+
+template<typename Executor>
+inline auto BasicSessionPool<Executor>::async_start(request_pointer request, auto&& token)
+{
+	auto& session = _select(*request);
+	request->_bind(session);
+	return session.async_start(std::move(request), std::forward<decltype(token)>(token));
+}
+
+template<typename Executor>
+template<typename Mutex>
+inline void BasicSessionPool<Executor>::set_share(BasicShare<Mutex>& share)
+{
+	for (const auto& session : _sessions) {
+		session->set_share(share);
+	}
+}
+
+template<typename Executor>
+inline void BasicSessionPool<Executor>::set_resolver(BasicResolver<Executor>& resolver)
+{
+	for (const auto& session : _sessions) {
+		session->set_resolver(resolver);
+	}
+}
+
+template<typename Executor>
+inline void BasicSessionPool<Executor>::set_socket_policy(const SocketPolicy& policy)
+{
+	for (const auto& session : _sessions) {
+		session->set_socket_policy(policy);
+	}
+}
+
+template<typename Executor>
+inline void BasicSessionPool<Executor>::set_admission_limits(std::size_t max_transfers,
+                                                             std::size_t max_transfers_per_origin)
+{
+	for (const auto& session : _sessions) {
+		session->set_admission_limits(max_transfers, max_transfers_per_origin);
+	}
+}
+
+template<typename Executor>
+inline void BasicSessionPool<Executor>::set_request_pool(const std::shared_ptr<RequestPool>& pool) noexcept
+{
+	for (const auto& session : _sessions) {
+		session->set_request_pool(pool);
+	}
+}
+
+template<typename Executor>
+inline std::size_t BasicSessionPool<Executor>::size() const noexcept
+{
+	return _sessions.size();
+}
+
+template<typename Executor>
+inline typename BasicSessionPool<Executor>::session_type&
+  BasicSessionPool<Executor>::get_session(std::size_t index) noexcept
+{
+	CURLIO_ASSERT(index < _sessions.size());
+	return *_sessions[index];
+}
+
+template<typename Executor>
+inline typename BasicSessionPool<Executor>::Placement BasicSessionPool<Executor>::get_placement() const noexcept
+{
+	return _placement;
+}
+
+template<typename Executor>
+inline typename BasicSessionPool<Executor>::session_type&
+  BasicSessionPool<Executor>::_select(const BasicRequest<Executor>& request) noexcept
+{
+	if (_placement == Placement::host_affinity) {
+		if (const auto origin = detail::parse_origin(request._url.c_str()); origin.has_value()) {
+			const auto index = std::hash<std::string>{}(origin->to_string()) % _sessions.size();
+			CURLIO_TRACE("Placing request for " << origin->to_string() << " in session " << index);
+			return *_sessions[index];
+		}
+	}
+
+	const std::size_t start = _next.fetch_add(1, std::memory_order_relaxed);
+	std::size_t best        = start % _sessions.size();
+	std::size_t best_count  = std::numeric_limits<std::size_t>::max();
+	for (std::size_t i = 0; i < _sessions.size(); ++i) {
+		const std::size_t index = (start + i) % _sessions.size();
+		const std::size_t count = _sessions[index]->get_active_count();
+		if (count < best_count) {
+			best       = index;
+			best_count = count;
+		}
+	}
+	CURLIO_TRACE("Placing request in session " << best << " with " << best_count << " active transfers");
+	return *_sessions[best];
+}
+
+} // namespace cURLio
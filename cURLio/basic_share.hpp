@@ -0,0 +1,55 @@
+#pragma once
+
+#include "config.hpp"
+#include "detail/null_mutex.hpp"
+#include "fwd.hpp"
+
+#include <array>
+#include <curl/curl.h>
+#include <initializer_list>
+#include <mutex>
+
+namespace cURLio {
+
+/**
+ * Wraps a `CURLSH` (cURL share handle) which lets requests of different sessions use the same DNS cache and
+ * TLS sessions. This way a host is only resolved and fully handshaked once instead of once per session. The
+ * share must outlive all attached sessions and requests.
+ *
+ * The connection cache (`CURL_LOCK_DATA_CONNECT`) cannot be shared, because the sockets of a connection are
+ * owned and monitored by the session which opened them.
+ *
+ * @tparam Mutex Guards the shared data. If all attached sessions are run by the same thread,
+ * `detail::NullMutex` can be used which disables locking entirely.
+ */
+template<typename Mutex>
+class BasicShare {
+public:
+	using mutex_type = Mutex;
+
+	/// Shares the given data (`CURL_LOCK_DATA_*`) between all attached requests.
+	BasicShare(std::initializer_list<curl_lock_data> data = { CURL_LOCK_DATA_DNS, CURL_LOCK_DATA_SSL_SESSION });
+	BasicShare(const BasicShare& copy) = delete;
+	BasicShare(BasicShare&& move)      = delete;
+	~BasicShare();
+
+	CURLIO_NO_DISCARD CURLSH* native_handle() const noexcept;
+
+	BasicShare& operator=(const BasicShare& copy) = delete;
+	BasicShare& operator=(BasicShare&& move)      = delete;
+
+private:
+	CURLSH* _handle;
+	/// One mutex per kind of data so that e.g. a DNS lookup does not block a TLS handshake.
+	std::array<Mutex, CURL_LOCK_DATA_LAST> _mutexes{};
+
+	static void _lock_callback(CURL* easy_handle, curl_lock_data data, curl_lock_access access,
+	                           void* self_ptr) noexcept;
+	static void _unlock_callback(CURL* easy_handle, curl_lock_data data, void* self_ptr) noexcept;
+};
+
+using Share = BasicShare<std::mutex>;
+/// A share for sessions that are all run by the same thread.
+using LocalShare = BasicShare<detail::NullMutex>;
+
+} // namespace cURLio
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "basic_share.hpp"
+#include "debug.hpp"
+#include "detail/final_action.hpp"
+
+#include <type_traits>
+
+namespace cURLio {
+
+template<typename Mutex>
+inline BasicShare<Mutex>::BasicShare(std::initializer_list<curl_lock_data> data)
+{
+	for (const auto value : data) {
+		if (value == CURL_LOCK_DATA_CONNECT) {
+			throw std::system_error{ Code::unsupported_share_data };
+		}
+	}
+
+	_handle = curl_share_init();
+	// The destructor does not run if the constructor throws.
+	auto cleanup_share = detail::finally([this] { curl_share_cleanup(_handle); });
+	if constexpr (!std::is_same_v<Mutex, detail::NullMutex>) {
+		CURLIO_SHARE_ASSERT(curl_share_setopt(_handle, CURLSHOPT_LOCKFUNC, &BasicShare::_lock_callback));
+		CURLIO_SHARE_ASSERT(curl_share_setopt(_handle, CURLSHOPT_UNLOCKFUNC, &BasicShare::_unlock_callback));
+		CURLIO_SHARE_ASSERT(curl_share_setopt(_handle, CURLSHOPT_USERDATA, this));
+	}
+	for (const auto value : data) {
+		CURLIO_SHARE_ASSERT(curl_share_setopt(_handle, CURLSHOPT_SHARE, value));
+	}
+	cleanup_share.cancel();
+}
+
+template<typename Mutex>
+inline BasicShare<Mutex>::~BasicShare()
+{
+	CURLIO_SHARE_CHECK(curl_share_cleanup(_handle));
+}
+
+template<typename Mutex>
+inline CURLSH* BasicShare<Mutex>::native_handle() const noexcept
+{
+	return _handle;
+}
+
+template<typename Mutex>
+inline void BasicShare<Mutex>::_lock_callback(CURL* /* easy_handle */, curl_lock_data data,
+                                              curl_lock_access /* access */, void* self_ptr) noexcept
+{
+	static_cast<BasicShare*>(self_ptr)->_mutexes[data].lock();
+}
+
+template<typename Mutex>
+inline void BasicShare<Mutex>::_unlock_callback(CURL* /* easy_handle */, curl_lock_data data,
+                                                void* self_ptr) noexcept
+{
+	static_cast<BasicShare*>(self_ptr)->_mutexes[data].unlock();
+}
+
+} // namespace cURLio
@@ -61,3 +61,20 @@
 		}                                                                                                        \
 		return ::cURLio::detail::asio_error_code{};                                                              \
 	}()
+
+#define CURLIO_SHARE_ASSERT(expr)                                                                            \
+	if (const auto err = expr; err != CURLSHE_OK) {                                                            \
+		CURLIO_ERROR("Function " #expr " failed: " << curl_share_strerror(err));                                 \
+		throw std::system_error{ static_cast<::cURLio::Code>(                                                    \
+			static_cast<int>(::cURLio::Code::curl_share_reserved) + static_cast<int>(err)) };                      \
+	}
+#define CURLIO_SHARE_CHECK(expr)                                                                             \
+	[&] {                                                                                                      \
+		const auto err = expr;                                                                                   \
+		if (err != CURLSHE_OK) {                                                                                 \
+			CURLIO_ERROR("Function " #expr " failed: " << curl_share_strerror(err));                               \
+			return ::cURLio::detail::asio_error_code{ static_cast<::cURLio::Code>(                                 \
+				static_cast<int>(::cURLio::Code::curl_share_reserved) + static_cast<int>(err)) };                    \
+		}                                                                                                        \
+		return ::cURLio::detail::asio_error_code{};                                                              \
+	}()
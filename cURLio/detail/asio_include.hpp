@@ -4,10 +4,20 @@
 #	include <asio.hpp>
 #	define CURLIO_ASIO_NS asio
 #	define CURLIO_ASIO_HAS_CANCEL __has_include(<asio/cancellation_signal.hpp>)
+#	if defined(ASIO_HAS_LOCAL_SOCKETS)
+#		define CURLIO_ASIO_HAS_LOCAL_SOCKETS 1
+#	endif
 #else // Fall back to Boost.ASIO
 #	include <boost/asio.hpp>
 #	define CURLIO_ASIO_NS boost::asio
 #	define CURLIO_ASIO_HAS_CANCEL __has_include(<boost/asio/cancellation_signal.hpp>)
+#	if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+#		define CURLIO_ASIO_HAS_LOCAL_SOCKETS 1
+#	endif
+#endif
+
+#if !defined(CURLIO_ASIO_HAS_LOCAL_SOCKETS)
+#	define CURLIO_ASIO_HAS_LOCAL_SOCKETS 0
 #endif
 
 namespace cURLio::detail {
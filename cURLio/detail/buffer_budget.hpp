@@ -0,0 +1,71 @@
+#pragma once
+
+#include "function.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <utility>
+
+namespace cURLio::detail {
+
+/**
+ * Counts the bytes that the responses of a session buffered ahead of their readers. Transfers that would
+ * exceed the limit wait in arrival order and are woken one at a time whenever buffered data is released. Not
+ * thread-safe except for `used()`.
+ */
+class BufferBudget {
+public:
+	void set_limit(std::size_t limit)
+	{
+		_limit = limit;
+		_wake();
+	}
+	/// Takes the bytes if they fit into the limit.
+	bool try_acquire(std::size_t size) noexcept
+	{
+		if (_used + size > _limit) {
+			return false;
+		}
+		_add(size);
+		return true;
+	}
+	/// Takes the bytes even if they exceed the limit.
+	void acquire(std::size_t size) noexcept { _add(size); }
+	void release(std::size_t size)
+	{
+		_used -= size;
+		_used_mirror.store(_used, std::memory_order_relaxed);
+		_wake();
+	}
+	/// The waiter is called once there is room. It returns `false` if it did not resume a transfer, in which
+	/// case the next waiter is woken instead.
+	void wait(Function<bool()> waiter) { _waiters.push_back(std::move(waiter)); }
+	/// Safe to call from any thread.
+	std::size_t used() const noexcept { return _used_mirror.load(std::memory_order_relaxed); }
+
+private:
+	std::size_t _limit = std::numeric_limits<std::size_t>::max();
+	std::size_t _used  = 0;
+	std::atomic<std::size_t> _used_mirror{ 0 };
+	std::deque<Function<bool()>> _waiters{};
+
+	void _add(std::size_t size) noexcept
+	{
+		_used += size;
+		_used_mirror.store(_used, std::memory_order_relaxed);
+	}
+	void _wake()
+	{
+		while (!_waiters.empty() && _used < _limit) {
+			auto waiter = std::move(_waiters.front());
+			_waiters.pop_front();
+			if (waiter()) {
+				break;
+			}
+		}
+	}
+};
+
+} // namespace cURLio::detail
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "header_collector.hpp"
+
+#include <cctype>
+#include <chrono>
+#include <charconv>
+#include <ctime>
+#include <curl/curl.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cURLio::detail {
+
+/// The directives of a `Cache-Control` header which matter to a private cache.
+struct CacheControl {
+	bool no_store = false;
+	bool no_cache = false;
+	std::optional<std::chrono::seconds> max_age{};
+};
+
+/// Splits a comma separated header value like `Vary` into its trimmed and lower-cased elements.
+inline std::vector<std::string> split_list(std::string_view value)
+{
+	std::vector<std::string> elements{};
+	while (!value.empty()) {
+		const auto end     = value.find(',');
+		const auto element = trim(value.substr(0, end));
+		if (!element.empty()) {
+			auto& lowered = elements.emplace_back(element);
+			for (auto& c : lowered) {
+				c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+			}
+		}
+		value = end == std::string_view::npos ? std::string_view{} : value.substr(end + 1);
+	}
+	return elements;
+}
+
+inline CacheControl parse_cache_control(std::string_view value)
+{
+	CacheControl control{};
+	for (const auto& directive : split_list(value)) {
+		if (directive == "no-store") {
+			control.no_store = true;
+		} else if (directive == "no-cache") {
+			control.no_cache = true;
+		} else if (directive.rfind("max-age=", 0) == 0) {
+			long seconds = 0;
+			const auto begin = directive.data() + 8;
+			const auto end   = directive.data() + directive.size();
+			if (const auto [ptr, ec] = std::from_chars(begin, end, seconds); ec == std::errc{} && ptr == end) {
+				control.max_age = std::chrono::seconds{ seconds };
+			}
+		}
+	}
+	return control;
+}
+
+/// Parses an HTTP date (e.g. of `Expires`) with cURL.
+inline std::optional<std::time_t> parse_http_date(const std::string& value) noexcept
+{
+	const std::time_t time = curl_getdate(value.c_str(), nullptr);
+	if (time == -1) {
+		return std::nullopt;
+	}
+	return time;
+}
+
+} // namespace cURLio::detail
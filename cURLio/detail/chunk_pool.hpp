@@ -0,0 +1,216 @@
+#pragma once
+
+#include "asio_include.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace cURLio::detail {
+
+/**
+ * A free list of fixed-size chunks. Chunks are taken by a single consumer, the strand of the session, but may
+ * be returned from any thread. Returned chunks are pushed onto a lock-free stack which the consumer takes as
+ * a whole once its own list ran empty; since nobody else pops, the stack is not prone to ABA.
+ */
+class ChunkPool {
+public:
+	/// Matches the largest chunk that cURL hands to a write callback by default (`CURL_MAX_WRITE_SIZE`).
+	constexpr static std::size_t chunk_size = 16 * 1024;
+
+	struct Chunk {
+		Chunk* next       = nullptr;
+		std::size_t begin = 0;
+		std::size_t end   = 0;
+		char data[chunk_size];
+	};
+
+	/// @param max_idle Chunks returned to a pool with this many idle chunks are freed.
+	explicit ChunkPool(std::size_t max_idle = 4096) noexcept : _max_idle{ max_idle } {}
+	ChunkPool(const ChunkPool& copy) = delete;
+	ChunkPool(ChunkPool&& move)      = delete;
+	~ChunkPool()
+	{
+		_free(_local);
+		_free(_returned.load(std::memory_order_acquire));
+	}
+
+	/// Returns an empty chunk. Must only be called by the consumer.
+	Chunk* acquire()
+	{
+		if (_local == nullptr) {
+			_local = _returned.exchange(nullptr, std::memory_order_acquire);
+			if (_local == nullptr) {
+				return new Chunk;
+			}
+		}
+		const auto chunk = _local;
+		_local           = chunk->next;
+		_idle.fetch_sub(1, std::memory_order_relaxed);
+		chunk->next  = nullptr;
+		chunk->begin = 0;
+		chunk->end   = 0;
+		return chunk;
+	}
+	/// Safe to call from any thread.
+	void release(Chunk* chunk) noexcept
+	{
+		if (_idle.fetch_add(1, std::memory_order_relaxed) >= _max_idle) {
+			_idle.fetch_sub(1, std::memory_order_relaxed);
+			delete chunk;
+			return;
+		}
+		chunk->next = _returned.load(std::memory_order_relaxed);
+		while (!_returned.compare_exchange_weak(chunk->next, chunk, std::memory_order_release,
+		                                        std::memory_order_relaxed)) {
+		}
+	}
+	/// The number of chunks waiting to be reused. Safe to call from any thread.
+	std::size_t idle() const noexcept { return _idle.load(std::memory_order_relaxed); }
+
+	ChunkPool& operator=(const ChunkPool& copy) = delete;
+	ChunkPool& operator=(ChunkPool&& move)      = delete;
+
+private:
+	std::size_t _max_idle;
+	std::atomic<std::size_t> _idle{ 0 };
+	/// The chunks returned since the consumer last took them.
+	std::atomic<Chunk*> _returned{ nullptr };
+	/// The chunks owned by the consumer.
+	Chunk* _local = nullptr;
+
+	static void _free(Chunk* chunk) noexcept
+	{
+		while (chunk != nullptr) {
+			delete std::exchange(chunk, chunk->next);
+		}
+	}
+};
+
+/**
+ * A byte queue made of pooled chunks. Appending never moves buffered data and consumed chunks go back to the
+ * pool right away. Without a pool, chunks are allocated and freed directly. Not thread-safe.
+ */
+class ChunkQueue {
+public:
+	using Chunk = ChunkPool::Chunk;
+
+	/// Iterates the filled part of every chunk as `CURLIO_ASIO_NS::const_buffer`.
+	class const_iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type        = CURLIO_ASIO_NS::const_buffer;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = const value_type*;
+		using reference         = value_type;
+
+		const_iterator() = default;
+		explicit const_iterator(const Chunk* chunk) noexcept : _chunk{ chunk } {}
+
+		value_type operator*() const noexcept
+		{
+			return { _chunk->data + _chunk->begin, _chunk->end - _chunk->begin };
+		}
+		const_iterator& operator++() noexcept
+		{
+			_chunk = _chunk->next;
+			return *this;
+		}
+		const_iterator operator++(int) noexcept { return const_iterator{ std::exchange(_chunk, _chunk->next) }; }
+		bool operator==(const const_iterator& other) const noexcept { return _chunk == other._chunk; }
+		bool operator!=(const const_iterator& other) const noexcept { return _chunk != other._chunk; }
+
+	private:
+		const Chunk* _chunk = nullptr;
+	};
+	/// The buffered data as ASIO `ConstBufferSequence`. Invalidated by changes of the queue.
+	class const_buffers_type {
+	public:
+		explicit const_buffers_type(const Chunk* head) noexcept : _head{ head } {}
+
+		const_iterator begin() const noexcept { return const_iterator{ _head }; }
+		const_iterator end() const noexcept { return {}; }
+
+	private:
+		const Chunk* _head;
+	};
+
+	ChunkQueue() = default;
+	explicit ChunkQueue(std::shared_ptr<ChunkPool> pool) noexcept : _pool{ std::move(pool) } {}
+	ChunkQueue(const ChunkQueue& copy) = delete;
+	ChunkQueue(ChunkQueue&& move) noexcept
+	    : _pool{ std::move(move._pool) }, _head{ std::exchange(move._head, nullptr) },
+	      _tail{ std::exchange(move._tail, nullptr) }, _size{ std::exchange(move._size, 0) }
+	{}
+	~ChunkQueue() { consume(_size); }
+
+	void append(const char* data, std::size_t size)
+	{
+		_size += size;
+		while (size > 0) {
+			if (_tail == nullptr || _tail->end == ChunkPool::chunk_size) {
+				const auto chunk = _pool != nullptr ? _pool->acquire() : new Chunk;
+				(_tail == nullptr ? _head : _tail->next) = chunk;
+				_tail                                    = chunk;
+			}
+			const auto count = std::min(size, ChunkPool::chunk_size - _tail->end);
+			std::memcpy(_tail->data + _tail->end, data, count);
+			_tail->end += count;
+			data += count;
+			size -= count;
+		}
+	}
+	/// Removes `size` bytes from the front. Must not exceed the buffered size.
+	void consume(std::size_t size) noexcept
+	{
+		_size -= size;
+		while (_head != nullptr && size >= _head->end - _head->begin) {
+			size -= _head->end - _head->begin;
+			_release(std::exchange(_head, _head->next));
+		}
+		if (_head == nullptr) {
+			_tail = nullptr;
+		} else {
+			_head->begin += size;
+		}
+	}
+	const_buffers_type data() const noexcept { return const_buffers_type{ _head }; }
+	/// Returns the contiguous data at the front.
+	CURLIO_ASIO_NS::const_buffer front() const noexcept
+	{
+		return _head == nullptr ? CURLIO_ASIO_NS::const_buffer{} : *const_iterator{ _head };
+	}
+	std::size_t size() const noexcept { return _size; }
+
+	ChunkQueue& operator=(const ChunkQueue& copy) = delete;
+	ChunkQueue& operator=(ChunkQueue&& move) noexcept
+	{
+		consume(_size);
+		_pool = std::move(move._pool);
+		_head = std::exchange(move._head, nullptr);
+		_tail = std::exchange(move._tail, nullptr);
+		_size = std::exchange(move._size, 0);
+		return *this;
+	}
+
+private:
+	std::shared_ptr<ChunkPool> _pool{};
+	Chunk* _head      = nullptr;
+	Chunk* _tail      = nullptr;
+	std::size_t _size = 0;
+
+	void _release(Chunk* chunk) noexcept
+	{
+		if (_pool != nullptr) {
+			_pool->release(chunk);
+		} else {
+			delete chunk;
+		}
+	}
+};
+
+} // namespace cURLio::detail
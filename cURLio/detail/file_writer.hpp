@@ -0,0 +1,473 @@
+#pragma once
+
+#include "../debug.hpp"
+#include "asio_include.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#	include <fcntl.h>
+#	include <unistd.h>
+
+#	if defined(CURLIO_ENABLE_IO_URING) && defined(__linux__) && __has_include(<linux/io_uring.h>)
+#		include <linux/io_uring.h>
+#		include <sys/mman.h>
+#		include <sys/syscall.h>
+#		if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#			define CURLIO_HAS_IO_URING 1
+#		endif
+#	endif
+#	if !defined(CURLIO_HAS_IO_URING)
+#		define CURLIO_HAS_IO_URING 0
+#	endif
+
+namespace cURLio::detail {
+
+/**
+ * Writes a stream of data to consecutive positions of a file with `pwrite()`. By default every piece is
+ * written straight from the memory of the caller. With `O_DIRECT` or io_uring the data is gathered in aligned
+ * staging buffers instead, which are written once full. io_uring submits the full buffers in batches and
+ * only waits for a write once all buffers are in flight. Not thread-safe. Only available on POSIX systems.
+ */
+class FileWriter {
+public:
+	struct Options {
+		/// The position of the first byte in the file. Must be a multiple of `alignment` for direct writes.
+		std::uint64_t offset = 0;
+		/// Truncates an existing file. Otherwise the file is only overwritten where the data goes.
+		bool truncate = true;
+		/// Opens the file with `O_DIRECT` to bypass the page cache. Falls back to buffered writes if the file
+		/// system does not support it.
+		bool direct = false;
+		/// The alignment of the memory, the positions and the sizes of direct writes.
+		std::size_t alignment = 4096;
+		/// Submits the writes through io_uring. Needs Linux and `CURLIO_ENABLE_IO_URING`, otherwise `pwrite()` is
+		/// used.
+		bool io_uring = false;
+		/// The size of a staging buffer. Rounded up to the alignment.
+		std::size_t buffer_size = 1024 * 1024;
+		/// The number of staging buffers of io_uring, which is the maximum of writes in flight.
+		std::size_t buffer_count = 4;
+		/// Flushes the file with `fsync()` at the end.
+		bool sync = false;
+	};
+
+	FileWriter() = default;
+	FileWriter(const FileWriter& copy) = delete;
+	FileWriter(FileWriter&& move)      = delete;
+	~FileWriter() { _close(); }
+
+	asio_error_code open(const std::filesystem::path& path, const Options& options)
+	{
+		_options  = options;
+		_position = options.offset;
+		if (options.direct && (options.alignment == 0 || options.offset % options.alignment != 0)) {
+			return make_error_code(CURLIO_ASIO_NS::error::invalid_argument);
+		}
+
+		const int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (options.truncate ? O_TRUNC : 0);
+#	if defined(O_DIRECT)
+		if (options.direct) {
+			_fd     = ::open(path.c_str(), flags | O_DIRECT, 0644);
+			_direct = _fd >= 0;
+		}
+#	endif
+		if (_fd < 0) {
+			_fd = ::open(path.c_str(), flags, 0644);
+			if (_fd < 0) {
+				return _last_error();
+			}
+		}
+
+#	if CURLIO_HAS_IO_URING
+		if (options.io_uring) {
+			_ring.emplace();
+			if (!_ring->open(static_cast<unsigned>(std::max<std::size_t>(options.buffer_count, 2)))) {
+				CURLIO_WARN("Falling back to pwrite() because io_uring is unavailable: " << std::strerror(errno));
+				_ring.reset();
+			}
+		}
+#	endif
+
+		if (_direct || _ring_enabled()) {
+			const std::size_t alignment = std::max<std::size_t>(options.alignment, 1);
+			_buffer_size = (std::max(options.buffer_size, alignment) + alignment - 1) / alignment * alignment;
+			_buffers.resize(_ring_enabled() ? std::max<std::size_t>(options.buffer_count, 2) : 1);
+			for (auto& buffer : _buffers) {
+				buffer.data.reset(static_cast<char*>(std::aligned_alloc(alignment, _buffer_size)));
+				if (buffer.data == nullptr) {
+					return make_error_code(CURLIO_ASIO_NS::error::no_memory);
+				}
+			}
+		}
+		return {};
+	}
+	/// Writes the data or stages it. Fails with the first error of any earlier write.
+	asio_error_code write(const char* data, std::size_t size)
+	{
+		if (_error) {
+			return _error;
+		} else if (_buffers.empty()) {
+			_error = _write_all(data, size, _position);
+			if (!_error) {
+				_position += size;
+				_written += size;
+			}
+			return _error;
+		}
+
+		while (size > 0) {
+			auto& buffer     = _buffers[_current];
+			const auto count = std::min(size, _buffer_size - buffer.size);
+			std::memcpy(buffer.data.get() + buffer.size, data, count);
+			buffer.size += count;
+			data += count;
+			size -= count;
+			if (buffer.size == _buffer_size) {
+				if (const auto ec = _flush(); ec) {
+					return _error = ec;
+				}
+			}
+		}
+		return {};
+	}
+	/// Writes the staged data, optionally calls `fsync()` and closes the file. Returns the first error.
+	asio_error_code finish(bool sync)
+	{
+		if (_fd < 0) {
+			return _error;
+		}
+
+		if (const auto ec = _wait_all(); ec && !_error) {
+			_error = ec;
+		}
+		if (!_error && !_buffers.empty() && _buffers[_current].size > 0) {
+			_error = _write_tail(_buffers[_current]);
+		}
+		if (!_error && sync) {
+			if (::fsync(_fd) == 0) {
+				_synced = true;
+			} else {
+				_error = _last_error();
+			}
+		}
+		_close();
+		return _error;
+	}
+	/// The bytes which reached the file.
+	std::uint64_t written() const noexcept { return _written; }
+	bool synced() const noexcept { return _synced; }
+
+	FileWriter& operator=(const FileWriter& copy) = delete;
+	FileWriter& operator=(FileWriter&& move)      = delete;
+
+private:
+	struct Free {
+		void operator()(char* data) const noexcept { std::free(data); }
+	};
+	struct Buffer {
+		std::unique_ptr<char, Free> data{};
+		std::size_t size       = 0;
+		std::uint64_t position = 0;
+		/// Whether io_uring is writing the buffer.
+		bool busy = false;
+	};
+
+#	if CURLIO_HAS_IO_URING
+	/// A minimal io_uring instance driven by the raw system calls, so that no liburing is needed.
+	class Ring {
+	public:
+		Ring()                 = default;
+		Ring(const Ring& copy) = delete;
+		~Ring()
+		{
+			if (_fd >= 0) {
+				_unmap();
+				::close(_fd);
+			}
+		}
+
+		bool open(unsigned entries) noexcept
+		{
+			io_uring_params params{};
+			_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+			if (_fd < 0) {
+				return false;
+			}
+
+			_sq_size   = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			_cq_size   = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+			_sq        = _map(_sq_size, IORING_OFF_SQ_RING);
+			_cq        = _map(_cq_size, IORING_OFF_CQ_RING);
+			_sqes      = static_cast<io_uring_sqe*>(_map(_sqes_size, IORING_OFF_SQES));
+			if (_sq == MAP_FAILED || _cq == MAP_FAILED || _sqes == MAP_FAILED) {
+				_unmap();
+				::close(std::exchange(_fd, -1));
+				return false;
+			}
+
+			_sq_tail  = _at<unsigned>(_sq, params.sq_off.tail);
+			_sq_mask  = _at<unsigned>(_sq, params.sq_off.ring_mask);
+			_sq_array = _at<unsigned>(_sq, params.sq_off.array);
+			_cq_head  = _at<unsigned>(_cq, params.cq_off.head);
+			_cq_tail  = _at<unsigned>(_cq, params.cq_off.tail);
+			_cq_mask  = _at<unsigned>(_cq, params.cq_off.ring_mask);
+			_cqes     = _at<io_uring_cqe>(_cq, params.cq_off.cqes);
+			return true;
+		}
+		/// Queues a write. The caller must not queue more writes than the ring has entries.
+		void write(int fd, const char* data, std::size_t size, std::uint64_t position,
+		           std::uint64_t user_data) noexcept
+		{
+			const unsigned tail  = *_sq_tail;
+			const unsigned index = tail & *_sq_mask;
+			auto& sqe            = _sqes[index];
+			std::memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode    = IORING_OP_WRITE;
+			sqe.fd        = fd;
+			sqe.addr      = reinterpret_cast<std::uintptr_t>(data);
+			sqe.len       = static_cast<std::uint32_t>(size);
+			sqe.off       = position;
+			sqe.user_data = user_data;
+
+			_sq_array[index] = index;
+			__atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+			++_queued;
+		}
+		/// Submits the queued writes and waits for `min_complete` completions. Returns `false` on errors.
+		bool enter(unsigned min_complete) noexcept
+		{
+			while (true) {
+				const auto submitted = ::syscall(__NR_io_uring_enter, _fd, _queued, min_complete,
+				                                 min_complete > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+				if (submitted >= 0) {
+					_queued -= static_cast<unsigned>(submitted);
+					return true;
+				} else if (errno != EINTR) {
+					return false;
+				}
+			}
+		}
+		/// Takes the next completion if there is one.
+		bool pop(std::uint64_t& user_data, std::int32_t& result) noexcept
+		{
+			const unsigned head = *_cq_head;
+			if (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+				return false;
+			}
+			const auto& cqe = _cqes[head & *_cq_mask];
+			user_data       = cqe.user_data;
+			result          = cqe.res;
+			__atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+			return true;
+		}
+		unsigned queued() const noexcept { return _queued; }
+
+		Ring& operator=(const Ring& copy) = delete;
+
+	private:
+		int _fd                = -1;
+		void* _sq              = MAP_FAILED;
+		void* _cq              = MAP_FAILED;
+		io_uring_sqe* _sqes    = static_cast<io_uring_sqe*>(MAP_FAILED);
+		std::size_t _sq_size   = 0;
+		std::size_t _cq_size   = 0;
+		std::size_t _sqes_size = 0;
+		unsigned* _sq_tail     = nullptr;
+		unsigned* _sq_mask     = nullptr;
+		unsigned* _sq_array    = nullptr;
+		unsigned* _cq_head     = nullptr;
+		unsigned* _cq_tail     = nullptr;
+		unsigned* _cq_mask     = nullptr;
+		io_uring_cqe* _cqes    = nullptr;
+		/// The writes queued but not submitted yet.
+		unsigned _queued = 0;
+
+		void* _map(std::size_t size, off_t offset) noexcept
+		{
+			return ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, offset);
+		}
+		void _unmap() noexcept
+		{
+			if (_sq != MAP_FAILED) {
+				::munmap(_sq, _sq_size);
+			}
+			if (_cq != MAP_FAILED) {
+				::munmap(_cq, _cq_size);
+			}
+			if (_sqes != MAP_FAILED) {
+				::munmap(_sqes, _sqes_size);
+			}
+		}
+		template<typename Type>
+		static Type* _at(void* base, std::uint32_t offset) noexcept
+		{
+			return reinterpret_cast<Type*>(static_cast<char*>(base) + offset);
+		}
+	};
+#	endif
+
+	Options _options{};
+	int _fd      = -1;
+	bool _direct = false;
+	bool _synced = false;
+	/// The position of the next write.
+	std::uint64_t _position = 0;
+	std::uint64_t _written  = 0;
+	asio_error_code _error{};
+	std::size_t _buffer_size = 0;
+	/// Empty if the data is written straight away.
+	std::vector<Buffer> _buffers{};
+	/// The buffer being filled.
+	std::size_t _current = 0;
+#	if CURLIO_HAS_IO_URING
+	/// Destroyed before the buffers it writes.
+	std::optional<Ring> _ring{};
+#	endif
+
+	bool _ring_enabled() const noexcept
+	{
+#	if CURLIO_HAS_IO_URING
+		return _ring.has_value();
+#	else
+		return false;
+#	endif
+	}
+	/// Writes the full buffer and continues with the next one.
+	asio_error_code _flush()
+	{
+		auto& buffer    = _buffers[_current];
+		buffer.position = _position;
+		_position += buffer.size;
+
+#	if CURLIO_HAS_IO_URING
+		if (_ring) {
+			buffer.busy = true;
+			_ring->write(_fd, buffer.data.get(), buffer.size, buffer.position, _current);
+			_current = (_current + 1) % _buffers.size();
+			// Submits half of the buffers at once.
+			if (_ring->queued() >= _buffers.size() / 2 && !_ring->enter(0)) {
+				return _last_error();
+			}
+			return _wait(_buffers[_current]);
+		}
+#	endif
+
+		const auto ec = _write_all(buffer.data.get(), buffer.size, buffer.position);
+		if (!ec) {
+			_written += buffer.size;
+		}
+		buffer.size = 0;
+		return ec;
+	}
+	/// Writes the last buffer, whose end is not aligned. The aligned part is written directly.
+	asio_error_code _write_tail(Buffer& buffer)
+	{
+		const std::size_t alignment = std::max<std::size_t>(_options.alignment, 1);
+		const std::size_t aligned   = _direct ? buffer.size / alignment * alignment : buffer.size;
+		if (const auto ec = _write_all(buffer.data.get(), aligned, _position); ec) {
+			return ec;
+		}
+		_written += aligned;
+		if (aligned < buffer.size) {
+#	if defined(O_DIRECT)
+			if (::fcntl(_fd, F_SETFL, ::fcntl(_fd, F_GETFL) & ~O_DIRECT) != 0) {
+				return _last_error();
+			}
+#	endif
+			if (const auto ec = _write_all(buffer.data.get() + aligned, buffer.size - aligned, _position + aligned);
+			    ec) {
+				return ec;
+			}
+			_written += buffer.size - aligned;
+		}
+		_position += buffer.size;
+		buffer.size = 0;
+		return {};
+	}
+	/// Waits until io_uring finished writing the buffer.
+	asio_error_code _wait([[maybe_unused]] Buffer& buffer)
+	{
+		asio_error_code error{};
+#	if CURLIO_HAS_IO_URING
+		while (buffer.busy) {
+			if (!_ring->enter(1)) {
+				return _last_error();
+			}
+			std::uint64_t index = 0;
+			std::int32_t result = 0;
+			while (_ring->pop(index, result)) {
+				auto& done = _buffers[index];
+				done.busy  = false;
+				asio_error_code ec{};
+				if (result < 0) {
+					ec = { -result, CURLIO_ASIO_NS::error::get_system_category() };
+				} else if (static_cast<std::size_t>(result) < done.size) {
+					// Continues a short write synchronously.
+					ec = _write_all(done.data.get() + result, done.size - result, done.position + result);
+				}
+				if (ec) {
+					error = ec;
+				} else {
+					_written += done.size;
+				}
+				done.size = 0;
+			}
+		}
+#	endif
+		return error;
+	}
+	asio_error_code _wait_all()
+	{
+		asio_error_code error{};
+		for (auto& buffer : _buffers) {
+			if (const auto ec = _wait(buffer); ec && !error) {
+				error = ec;
+			}
+		}
+		return error;
+	}
+	asio_error_code _write_all(const char* data, std::size_t size, std::uint64_t position) const
+	{
+		while (size > 0) {
+			const auto written = ::pwrite(_fd, data, size, static_cast<off_t>(position));
+			if (written < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return _last_error();
+			}
+			data += written;
+			size -= static_cast<std::size_t>(written);
+			position += static_cast<std::uint64_t>(written);
+		}
+		return {};
+	}
+	void _close() noexcept
+	{
+		if (_fd >= 0) {
+			// The kernel must be done with the buffers.
+			_wait_all();
+			::close(std::exchange(_fd, -1));
+		}
+	}
+	static asio_error_code _last_error() noexcept
+	{
+		return { errno, CURLIO_ASIO_NS::error::get_system_category() };
+	}
+};
+
+} // namespace cURLio::detail
+
+#endif
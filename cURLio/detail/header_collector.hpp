@@ -60,13 +60,45 @@ public:
 			return err;
 		}
 
+		finish();
+		return {};
+	}
+	/// Completes a header section as if it was received from cURL. For collectors which are not hooked into
+	/// cURL.
+	void feed(fields_type fields)
+	{
+		_fields     = std::move(fields);
+		_last_clear = ++_headers_received;
+		_complete_section();
+	}
+	/// Marks the headers as finished like `stop()` without touching the hooks.
+	void finish()
+	{
 		_finished = true;
 		if (_headers_received_handler) {
 			_headers_received_handler(CURLIO_ASIO_NS::error::eof);
 			_headers_received_handler.reset();
 		}
-		return {};
+		if (_observer) {
+			std::exchange(_observer, {})(CURLIO_ASIO_NS::error::eof, {});
+		}
+	}
+	/// Calls the observer with the fields of every completed header section and once with `eof` when the
+	/// headers are finished. If a section was already completed, the observer is called right away with its
+	/// fields, unless they were taken by `async_wait()`. Unlike `async_wait()` this leaves the fields for the
+	/// waiters. The observer may be called from within a cURL callback.
+	void observe(Function<void(asio_error_code, const fields_type&)> observer)
+	{
+		if (_finished) {
+			observer(CURLIO_ASIO_NS::error::eof, {});
+			return;
+		} else if (_headers_received > 0) {
+			observer({}, _fields);
+		}
+		_observer = std::move(observer);
 	}
+	/// Removes the observer without calling it.
+	void unobserve() noexcept { _observer = {}; }
 	auto async_wait(auto&& fallback_executor, auto&& token)
 	{
 		return CURLIO_ASIO_NS::async_initiate<decltype(token), void(asio_error_code, fields_type)>(
@@ -75,14 +107,14 @@ public:
 			    handler, std::forward<decltype(fallback_executor)>(fallback_executor));
 
 			  // Already received.
-			  if (_finished) {
-				  CURLIO_ASIO_NS::post(
-				    std::move(executor),
-				    std::bind(std::move(handler), asio_error_code{ CURLIO_ASIO_NS::error::eof }, std::move(_fields)));
-			  } else if (_ready_to_await) {
+			  if (_ready_to_await) {
 				  _ready_to_await = false;
 				  CURLIO_ASIO_NS::post(std::move(executor),
 				                       std::bind(std::move(handler), asio_error_code{}, std::move(_fields)));
+			  } else if (_finished) {
+				  CURLIO_ASIO_NS::post(
+				    std::move(executor),
+				    std::bind(std::move(handler), asio_error_code{ CURLIO_ASIO_NS::error::eof }, std::move(_fields)));
 			  } else if (_headers_received_handler) {
 				  CURLIO_ASIO_NS::post(std::move(executor),
 				                       std::bind(std::move(handler),
@@ -122,6 +154,21 @@ private:
 	bool _ready_to_await            = false;
 	bool _finished                  = false;
 	Function<void(asio_error_code)> _headers_received_handler;
+	Function<void(asio_error_code, const fields_type&)> _observer;
+
+	void _complete_section()
+	{
+		CURLIO_TRACE("End of header: waiter=" << static_cast<bool>(_headers_received_handler));
+		_ready_to_await = true;
+		// Before the waiter takes the fields.
+		if (_observer) {
+			_observer({}, _fields);
+		}
+		if (_headers_received_handler) {
+			_headers_received_handler({});
+			_headers_received_handler.reset();
+		}
+	}
 
 	static std::size_t _header_callback(char* buffer, std::size_t size, std::size_t count,
 	                                    void* self_ptr) noexcept
@@ -151,13 +198,8 @@ private:
 
 		// End of header.
 		if (total_length == 2) {
-			CURLIO_TRACE("End of header: waiter=" << static_cast<bool>(self->_headers_received_handler));
 			self->_headers_received++;
-			self->_ready_to_await = true;
-			if (self->_headers_received_handler) {
-				self->_headers_received_handler({});
-				self->_headers_received_handler.reset();
-			}
+			self->_complete_section();
 		}
 
 		return total_length;
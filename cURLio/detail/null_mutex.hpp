@@ -0,0 +1,11 @@
+#pragma once
+
+namespace cURLio::detail {
+
+/// A mutex that does nothing. For data that is only accessed by one thread at a time.
+struct NullMutex {
+	void lock() noexcept {}
+	void unlock() noexcept {}
+};
+
+} // namespace cURLio::detail
@@ -216,6 +216,11 @@ struct Option_type<
 	using type = void*;
 };
 
+template<CURLoption Option>
+struct Option_type<Option, std::enable_if_t<contains<Option, CURLOPT_SHARE>>> {
+	using type = CURLSH*;
+};
+
 template<CURLoption Option>
 struct Option_type<Option,
                    std::enable_if_t<(Option > CURLOPTTYPE_OFF_T && Option < CURLOPTTYPE_OFF_T + 10'000)>> {
@@ -231,4 +236,35 @@ struct Option_type<Option,
 template<CURLoption Option>
 using option_type = typename Option_type<Option>::type;
 
+/// The options which `BasicRequest::set_option()` mirrors in the state of the request, like the URL, the
+/// method and the credentials.
+template<CURLoption Option>
+constexpr bool is_tracked_option =
+  contains<Option, CURLOPT_URL, CURLOPT_SHARE, CURLOPT_RESOLVE, CURLOPT_CUSTOMREQUEST, CURLOPT_HTTPGET,
+           CURLOPT_NOBODY, CURLOPT_UPLOAD, CURLOPT_POST, CURLOPT_POSTFIELDS, CURLOPT_COPYPOSTFIELDS,
+           CURLOPT_MIMEPOST, CURLOPT_RANGE, CURLOPT_USERPWD, CURLOPT_USERNAME, CURLOPT_PASSWORD,
+           CURLOPT_XOAUTH2_BEARER, CURLOPT_COOKIE, CURLOPT_COOKIEFILE, CURLOPT_COOKIELIST,
+           CURLOPT_RESUME_FROM, CURLOPT_RESUME_FROM_LARGE, CURLOPT_NETRC, CURLOPT_TIMECONDITION,
+           CURLOPT_HTTPHEADER>;
+
+/// The options of the multi handle that can be set by the user. Callbacks and their data are reserved for the
+/// session.
+template<CURLMoption Option, typename = void>
+struct Multi_option_type;
+
+template<CURLMoption Option>
+struct Multi_option_type<Option,
+                         std::enable_if_t<(Option > CURLOPTTYPE_LONG && Option < CURLOPTTYPE_LONG + 10'000)>> {
+	using type = long;
+};
+
+template<CURLMoption Option>
+struct Multi_option_type<Option,
+                         std::enable_if_t<(Option > CURLOPTTYPE_OFF_T && Option < CURLOPTTYPE_OFF_T + 10'000)>> {
+	using type = curl_off_t;
+};
+
+template<CURLMoption Option>
+using multi_option_type = typename Multi_option_type<Option>::type;
+
 } // namespace cURLio::detail
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "final_action.hpp"
+
+#include <curl/curl.h>
+#include <optional>
+#include <string>
+
+namespace cURLio::detail {
+
+/// The scheme, host and port of an URL. Used to group transfers by their remote.
+struct Origin {
+	std::string scheme;
+	std::string host;
+	std::string port;
+
+	/// Returns `scheme://host:port`.
+	std::string to_string() const { return scheme + "://" + host + ":" + port; }
+	bool operator==(const Origin& other) const noexcept
+	{
+		return scheme == other.scheme && host == other.host && port == other.port;
+	}
+	bool operator<(const Origin& other) const noexcept
+	{
+		if (scheme != other.scheme) {
+			return scheme < other.scheme;
+		} else if (host != other.host) {
+			return host < other.host;
+		}
+		return port < other.port;
+	}
+};
+
+/// Parses the origin of the given URL with the URL API of cURL. The port is filled with the default port of the
+/// scheme if not explicitly given.
+inline std::optional<Origin> parse_origin(const char* url) noexcept
+{
+	if (url == nullptr) {
+		return std::nullopt;
+	}
+
+	CURLU* handle = curl_url();
+	if (handle == nullptr) {
+		return std::nullopt;
+	}
+	const auto _ = finally([handle] { curl_url_cleanup(handle); });
+
+	if (curl_url_set(handle, CURLUPART_URL, url, CURLU_GUESS_SCHEME) != CURLUE_OK) {
+		return std::nullopt;
+	}
+
+	const auto get = [handle](CURLUPart part, unsigned int flags) -> std::optional<std::string> {
+		char* value = nullptr;
+		if (curl_url_get(handle, part, &value, flags) != CURLUE_OK) {
+			return std::nullopt;
+		}
+		const auto _ = finally([value] { curl_free(value); });
+		try {
+			return std::string{ value };
+		} catch (...) {
+			return std::nullopt;
+		}
+	};
+
+	auto scheme = get(CURLUPART_SCHEME, 0);
+	auto host   = get(CURLUPART_HOST, 0);
+	auto port   = get(CURLUPART_PORT, CURLU_DEFAULT_PORT);
+	if (!scheme || !host || !port) {
+		return std::nullopt;
+	}
+	return Origin{ std::move(*scheme), std::move(*host), std::move(*port) };
+}
+
+} // namespace cURLio::detail
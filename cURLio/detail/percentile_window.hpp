@@ -0,0 +1,35 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+namespace cURLio::detail {
+
+/// Keeps the last `Capacity` samples and computes percentiles over them.
+template<typename Value, std::size_t Capacity>
+class PercentileWindow {
+public:
+	void add(Value value) noexcept
+	{
+		_values[_next] = value;
+		_next          = (_next + 1) % Capacity;
+		_size          = std::min(_size + 1, Capacity);
+	}
+	/// Returns the percentile (between 0 and 1) of the kept samples. The window must not be empty.
+	Value percentile(double percentile) const noexcept
+	{
+		auto values      = _values;
+		const auto index = std::min(static_cast<std::size_t>(percentile * _size), _size - 1);
+		std::nth_element(values.begin(), values.begin() + index, values.begin() + _size);
+		return values[index];
+	}
+	std::size_t size() const noexcept { return _size; }
+
+private:
+	std::array<Value, Capacity> _values{};
+	std::size_t _next = 0;
+	std::size_t _size = 0;
+};
+
+} // namespace cURLio::detail
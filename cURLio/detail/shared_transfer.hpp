@@ -0,0 +1,214 @@
+#pragma once
+
+#include "asio_include.hpp"
+#include "function.hpp"
+#include "header_collector.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cURLio::detail {
+
+/**
+ * The header sections and the body of a transfer that is read by multiple responses. The body is kept in a
+ * chain of reference-counted chunks. Every reader holds a cursor into the chain and chunks are freed once all
+ * cursors moved past them. While the transfer is joinable, the chain is also retained from its start so that
+ * late readers receive the complete body. The slowest reader holds the transfer back: once it lags more than
+ * `max_retained` bytes behind, the transfer is congested until the reader caught up by half of that. Not
+ * thread-safe.
+ */
+class SharedTransfer {
+public:
+	struct Chunk {
+		/// Points into `storage` or into memory that is kept alive by `owner`.
+		const char* data = nullptr;
+		std::size_t size = 0;
+		/// The offset of the chunk in the body.
+		std::size_t position = 0;
+		std::vector<char> storage{};
+		std::shared_ptr<const void> owner{};
+		std::shared_ptr<Chunk> next{};
+
+		Chunk() = default;
+		Chunk(const Chunk& copy) = delete;
+		~Chunk()
+		{
+			// Unlinks the rest of the chain iteratively, because long chains would overflow the stack.
+			auto chunk = std::move(next);
+			while (chunk != nullptr && chunk.use_count() == 1) {
+				chunk = std::move(chunk->next);
+			}
+		}
+
+		Chunk& operator=(const Chunk& copy) = delete;
+	};
+	struct Cursor {
+		std::shared_ptr<const Chunk> chunk;
+		std::size_t offset = 0;
+	};
+
+	/// @param max_retained The transfer stops being joinable once its body exceeds this size and is congested
+	/// once its slowest reader lags more than this behind.
+	SharedTransfer(std::string key, std::size_t max_retained)
+	    : _key{ std::move(key) }, _max_retained{ max_retained }, _tail{ std::make_shared<Chunk>() },
+	      _head{ _tail }
+	{}
+	SharedTransfer(const SharedTransfer& copy) = delete;
+	SharedTransfer(SharedTransfer&& move)      = delete;
+
+	/// Creates a finished transfer with a single header section which replays the body starting at `head`.
+	static std::shared_ptr<SharedTransfer> replay(std::shared_ptr<Chunk> head, std::size_t size,
+	                                              HeaderCollector::fields_type fields)
+	{
+		auto transfer       = std::make_shared<SharedTransfer>(std::string{}, size);
+		transfer->_head     = std::move(head);
+		transfer->_tail     = transfer->_head;
+		transfer->_size     = size;
+		transfer->_finished = true;
+		transfer->_reason   = CURLIO_ASIO_NS::error::eof;
+		transfer->_sections.push_back(std::move(fields));
+		return transfer;
+	}
+
+	/// Returns a cursor at the start of the body. Its chunk is empty if the start was already released.
+	Cursor begin() const noexcept { return { _head, 0 }; }
+	/// Returns the first chunk of the chain which holds no data, or an empty pointer if it was released.
+	const std::shared_ptr<Chunk>& head() const noexcept { return _head; }
+	/// Appends a copy of the data and notifies the subscribers.
+	void append(const char* data, std::size_t size)
+	{
+		auto chunk = std::make_shared<Chunk>();
+		chunk->storage.assign(data, data + size);
+		chunk->data     = chunk->storage.data();
+		chunk->size     = size;
+		chunk->position = _size;
+		_tail->next     = chunk;
+		_tail           = std::move(chunk);
+		_size += size;
+		if (_size > _max_retained) {
+			_head.reset();
+		}
+		_notify();
+	}
+	/// Returns the unread data of the chunk at the cursor without consuming it. Empty if the cursor reached the
+	/// end of the received data.
+	std::pair<const char*, std::size_t> peek(Cursor& cursor) const noexcept
+	{
+		while (cursor.offset >= cursor.chunk->size && cursor.chunk->next != nullptr) {
+			cursor.chunk  = cursor.chunk->next;
+			cursor.offset = 0;
+		}
+		return { cursor.chunk->data + cursor.offset, cursor.chunk->size - cursor.offset };
+	}
+	void add_section(const HeaderCollector::fields_type& fields)
+	{
+		_sections.push_back(fields);
+		_notify();
+	}
+	/// Finishes the transfer, notifies the subscribers a last time and drops them. Releases the start of the
+	/// body, so that chunks are freed as the readers move on.
+	void finish(asio_error_code reason)
+	{
+		if (_finished) {
+			return;
+		}
+		_finished = true;
+		_reason   = reason;
+		_head.reset();
+		_notify();
+		_subscribers.clear();
+	}
+	/// The subscriber is called after every change until it returns `false` or the transfer is finished.
+	void subscribe(Function<bool()> subscriber) { _subscribers.push_back(std::move(subscriber)); }
+	/// Counts the cursor as reader until it expires.
+	void add_reader(std::weak_ptr<const Cursor> cursor) { _readers.push_back(std::move(cursor)); }
+	/// Returns `true` if the writer should hold back the data because the slowest reader lags too far behind.
+	bool congested()
+	{
+		if (!_congested && _backlog() > _max_retained) {
+			_congested = true;
+		}
+		return _congested;
+	}
+	/// Must be called after a reader moved its cursor or went away. Calls the drain callback once the readers
+	/// of a congested transfer caught up.
+	void advanced()
+	{
+		if (_congested && _backlog() <= _max_retained / 2) {
+			_congested = false;
+			if (_on_drained) {
+				_on_drained();
+			}
+		}
+	}
+	/// Sets the callback for `advanced()`.
+	void on_drained(Function<void()> callback) { _on_drained = std::move(callback); }
+	/// Sets the object which keeps the transfer running and returns the previous one.
+	std::shared_ptr<void> exchange_owner(std::shared_ptr<void> owner) noexcept
+	{
+		return std::exchange(_owner, std::move(owner));
+	}
+	const std::string& key() const noexcept { return _key; }
+	bool joinable() const noexcept { return _head != nullptr && !_finished; }
+	/// The number of received body bytes.
+	std::size_t size() const noexcept { return _size; }
+	bool finished() const noexcept { return _finished; }
+	asio_error_code reason() const noexcept { return _reason; }
+	const std::vector<HeaderCollector::fields_type>& sections() const noexcept { return _sections; }
+
+	SharedTransfer& operator=(const SharedTransfer& copy) = delete;
+	SharedTransfer& operator=(SharedTransfer&& move)      = delete;
+
+private:
+	std::string _key;
+	std::size_t _max_retained;
+	std::size_t _size = 0;
+	std::shared_ptr<Chunk> _tail;
+	/// The start of the body. Released once the transfer is not joinable anymore.
+	std::shared_ptr<Chunk> _head;
+	std::vector<HeaderCollector::fields_type> _sections{};
+	std::vector<Function<bool()>> _subscribers{};
+	std::shared_ptr<void> _owner{};
+	std::vector<std::weak_ptr<const Cursor>> _readers{};
+	Function<void()> _on_drained{};
+	bool _congested = false;
+	bool _finished  = false;
+	asio_error_code _reason{};
+
+	/// Returns the number of received bytes which the slowest reader did not read yet and forgets the readers
+	/// which went away.
+	std::size_t _backlog()
+	{
+		std::size_t slowest = _size;
+		for (std::size_t i = 0; i < _readers.size();) {
+			if (const auto cursor = _readers[i].lock(); cursor == nullptr) {
+				_readers[i] = std::move(_readers.back());
+				_readers.pop_back();
+			} else {
+				if (cursor->chunk != nullptr) {
+					slowest = std::min(slowest, cursor->chunk->position + cursor->offset);
+				}
+				++i;
+			}
+		}
+		return _size - slowest;
+	}
+
+	void _notify()
+	{
+		for (std::size_t i = 0; i < _subscribers.size();) {
+			if (_subscribers[i]()) {
+				++i;
+			} else {
+				_subscribers[i] = std::move(_subscribers.back());
+				_subscribers.pop_back();
+			}
+		}
+	}
+};
+
+} // namespace cURLio::detail
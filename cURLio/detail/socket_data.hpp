@@ -2,6 +2,10 @@
 
 #include "asio_include.hpp"
 
+#include <curl/curl.h>
+#include <utility>
+#include <variant>
+
 namespace cURLio::detail {
 
 struct SocketData {
@@ -10,8 +14,47 @@ struct SocketData {
 		wait_flag_read  = 0x2,
 	};
 
-	CURLIO_ASIO_NS::ip::tcp::socket socket;
+	/// TCP for remote hosts and Unix domain sockets for `CURLOPT_UNIX_SOCKET_PATH` and
+	/// `CURLOPT_ABSTRACT_UNIX_SOCKET`.
+	using socket_type = std::variant<CURLIO_ASIO_NS::ip::tcp::socket
+#if CURLIO_ASIO_HAS_LOCAL_SOCKETS
+	                                 ,
+	                                 CURLIO_ASIO_NS::local::stream_protocol::socket
+#endif
+	                                 >;
+
+	socket_type socket;
 	int wait_flags = 0;
+	/// The `CURL_CSELECT_*` events that occurred but were not yet passed to cURL.
+	int ready_events = 0;
+
+	curl_socket_t native_handle() noexcept
+	{
+		return std::visit([](auto& socket) { return socket.native_handle(); }, socket);
+	}
+	bool is_open() const noexcept
+	{
+		return std::visit([](const auto& socket) { return socket.is_open(); }, socket);
+	}
+	void async_wait(CURLIO_ASIO_NS::socket_base::wait_type type, auto&& handler)
+	{
+		std::visit([&](auto& socket) { socket.async_wait(type, std::forward<decltype(handler)>(handler)); },
+		           socket);
+	}
+	/// Cancels all pending waits. Errors are ignored since the socket is about to be removed anyway.
+	void cancel() noexcept
+	{
+		std::visit(
+		  [](auto& socket) {
+			  asio_error_code ec{};
+			  static_cast<void>(socket.cancel(ec));
+		  },
+		  socket);
+	}
+	void close(asio_error_code& ec) noexcept
+	{
+		std::visit([&](auto& socket) { static_cast<void>(socket.close(ec)); }, socket);
+	}
 };
 
 } // namespace cURLio::detail
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <curl/curl.h>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace cURLio::detail {
+
+/// Maps sockets to their data. Since POSIX file descriptors are small and dense, the table is a vector indexed
+/// by the descriptor which makes a lookup a single pointer chase. An empty (default constructed) value marks
+/// an unused slot.
+template<typename Value>
+class SocketTable {
+public:
+	/// Returns the value for the socket or `nullptr` if the socket is unknown.
+	Value* find(curl_socket_t socket) noexcept
+	{
+		if (socket < 0 || static_cast<std::size_t>(socket) >= _values.size() || !_values[socket]) {
+			return nullptr;
+		}
+		return &_values[socket];
+	}
+	void insert(curl_socket_t socket, Value value)
+	{
+		if (static_cast<std::size_t>(socket) >= _values.size()) {
+			// Grow geometrically so that a burst of new sockets does not reallocate every time.
+			_values.resize(std::max(static_cast<std::size_t>(socket) + 1, _values.size() * 2));
+		}
+		if (!_values[socket]) {
+			++_size;
+		}
+		_values[socket] = std::move(value);
+	}
+	/// Removes the socket and returns its value.
+	Value erase(curl_socket_t socket) noexcept
+	{
+		if (const auto value = find(socket); value != nullptr) {
+			--_size;
+			return std::exchange(*value, Value{});
+		}
+		return {};
+	}
+	std::size_t size() const noexcept { return _size; }
+	/// Calls the function for every known socket.
+	void for_each(auto&& function)
+	{
+		for (auto& value : _values) {
+			if (value) {
+				function(value);
+			}
+		}
+	}
+
+private:
+	std::vector<Value> _values{};
+	std::size_t _size = 0;
+};
+
+} // namespace cURLio::detail
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cURLio::detail {
+
+/**
+ * A hierarchical timer wheel. Scheduling and cancelling are constant time and advancing the time only touches
+ * the slots that became due, hence many thousand timers can share a single system timer. The wheel is not
+ * thread-safe and does not call the callbacks itself; they are handed to the caller of `advance()` which
+ * might schedule new timers while calling them.
+ *
+ * Timers are rounded up to the resolution, so they never expire early. The wheel spans 2^32 ticks (about 49
+ * days with a resolution of one millisecond); later timers expire at its end.
+ */
+template<typename Callback>
+class TimerWheel {
+public:
+	using clock_type = std::chrono::steady_clock;
+	using time_point = clock_type::time_point;
+	using id_type    = std::uint64_t;
+
+	TimerWheel(std::chrono::milliseconds resolution = std::chrono::milliseconds{ 1 },
+	           time_point start = clock_type::now())
+	    : _resolution{ resolution }, _start{ start }
+	{}
+
+	/// Returns the identifier for `cancel()`. Never returns zero.
+	id_type schedule(time_point expiry, Callback callback)
+	{
+		const id_type id = ++_last_id;
+		_insert(Entry{ id, std::max(_to_tick(expiry, true), _current + 1), std::move(callback) });
+		++_size;
+		if (_next.has_value()) {
+			_next = std::min(*_next, _processing_tick(id));
+		}
+		return id;
+	}
+	/// Removes the timer without calling it. Returns `false` if the timer already expired or is unknown.
+	bool cancel(id_type id) noexcept
+	{
+		const auto location = _locations.find(id);
+		if (location == _locations.end()) {
+			return false;
+		}
+		auto& slot        = _slots[location->second.level][location->second.slot];
+		const auto index  = location->second.index;
+		_locations.erase(location);
+		if (index + 1 != slot.size()) {
+			slot[index] = std::move(slot.back());
+			_locations[slot[index].id].index = index;
+		}
+		slot.pop_back();
+		--_size;
+		return true;
+	}
+	/// Moves the callbacks of all timers which expired until `now` to `expired`.
+	void advance(time_point now, std::vector<Callback>& expired)
+	{
+		const std::uint64_t target = _to_tick(now, false);
+		_next.reset();
+		if (_size == 0) {
+			_current = std::max(_current, target);
+			return;
+		}
+
+		while (_current < target && _size > 0) {
+			++_current;
+			// Cascade from the highest level that starts a new revolution with this tick.
+			std::size_t level = 0;
+			while (level + 1 < levels && _index(_current, level) == 0) {
+				++level;
+			}
+			for (; level > 0; --level) {
+				auto entries = std::move(_slots[level][_index(_current, level)]);
+				_slots[level][_index(_current, level)].clear();
+				for (auto& entry : entries) {
+					_insert(std::move(entry));
+				}
+			}
+
+			auto& slot = _slots[0][_index(_current, 0)];
+			for (auto& entry : slot) {
+				_locations.erase(entry.id);
+				expired.push_back(std::move(entry.callback));
+				--_size;
+			}
+			slot.clear();
+		}
+		_current = std::max(_current, target);
+	}
+	/// Returns the time at which `advance()` should be called next. Might be earlier than the next expiry.
+	std::optional<time_point> next_expiry() const
+	{
+		if (_size == 0) {
+			return std::nullopt;
+		} else if (!_next.has_value()) {
+			_next = _scan();
+		}
+		return _start + _resolution * static_cast<std::int64_t>(*_next);
+	}
+	std::size_t size() const noexcept { return _size; }
+	bool empty() const noexcept { return _size == 0; }
+
+private:
+	constexpr static std::size_t bits   = 8;
+	constexpr static std::size_t slots  = std::size_t{ 1 } << bits;
+	constexpr static std::size_t levels = 4;
+
+	struct Entry {
+		id_type id;
+		std::uint64_t tick;
+		Callback callback;
+	};
+	struct Location {
+		std::uint8_t level;
+		std::uint8_t slot;
+		std::size_t index;
+	};
+
+	std::chrono::milliseconds _resolution;
+	time_point _start;
+	/// The last tick that was processed.
+	std::uint64_t _current = 0;
+	id_type _last_id       = 0;
+	std::size_t _size      = 0;
+	/// A cached lower bound of the next tick that needs processing.
+	mutable std::optional<std::uint64_t> _next{};
+	std::array<std::array<std::vector<Entry>, slots>, levels> _slots{};
+	std::unordered_map<id_type, Location> _locations{};
+
+	static std::size_t _index(std::uint64_t tick, std::size_t level) noexcept
+	{
+		return (tick >> (bits * level)) & (slots - 1);
+	}
+	std::uint64_t _to_tick(time_point time, bool round_up) const noexcept
+	{
+		if (time <= _start) {
+			return 0;
+		}
+		const auto elapsed = time - _start;
+		auto ticks         = elapsed / _resolution;
+		if (round_up && _resolution * ticks < elapsed) {
+			++ticks;
+		}
+		return static_cast<std::uint64_t>(ticks);
+	}
+	void _insert(Entry&& entry)
+	{
+		const std::uint64_t max_delta = (std::uint64_t{ 1 } << (bits * levels)) - 1;
+		entry.tick                    = std::min(entry.tick, _current + max_delta);
+
+		const std::uint64_t delta = entry.tick - _current;
+		std::size_t level         = 0;
+		while (level + 1 < levels && delta >= (std::uint64_t{ 1 } << (bits * (level + 1)))) {
+			++level;
+		}
+		const auto index = _index(entry.tick, level);
+		auto& slot       = _slots[level][index];
+		_locations[entry.id] =
+		  Location{ static_cast<std::uint8_t>(level), static_cast<std::uint8_t>(index), slot.size() };
+		slot.push_back(std::move(entry));
+	}
+	/// The tick at which the timer must be processed, i.e. its expiry or the cascade of its slot.
+	std::uint64_t _processing_tick(id_type id) const noexcept
+	{
+		const auto& location = _locations.at(id);
+		const auto& entry    = _slots[location.level][location.slot][location.index];
+		if (location.level == 0) {
+			return entry.tick;
+		}
+		const std::size_t shift = bits * location.level;
+		return (entry.tick >> shift) << shift;
+	}
+	/// Finds the earliest tick at which a slot must be processed.
+	std::uint64_t _scan() const noexcept
+	{
+		std::uint64_t next = static_cast<std::uint64_t>(-1);
+		for (std::size_t level = 0; level < levels; ++level) {
+			const std::size_t shift = bits * level;
+			for (std::uint64_t i = 1; i <= slots; ++i) {
+				const std::uint64_t tick = ((_current >> shift) + i) << shift;
+				if (tick >= next) {
+					break;
+				} else if (!_slots[level][_index(tick, level)].empty()) {
+					next = tick;
+					break;
+				}
+			}
+		}
+		return next;
+	}
+};
+
+} // namespace cURLio::detail
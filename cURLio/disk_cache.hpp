@@ -0,0 +1,587 @@
+/**
+ * @file
+ *
+ * The persistent tier of `BasicCachingSession`.
+ */
+#pragma once
+
+#include "config.hpp"
+#include "debug.hpp"
+#include "detail/header_collector.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+
+namespace cURLio {
+
+/**
+ * Stores response bodies in a directory so that they survive restarts. Bodies are appended to segment files
+ * and described by an index, which is an append-only log of insertions and removals that is compacted when
+ * the cache is opened and closed. Hits are memory-mapped, so reading a cached body neither copies it nor
+ * needs a system call per chunk.
+ *
+ * Entries are evicted in LRU order once their bodies exceed the budget. Since segments are never rewritten,
+ * a full segment is deleted with its remaining entries once less than half of it is alive; thus the files
+ * take at most about twice the budget. The order of use is persisted when the cache is closed. Entries whose
+ * segment was lost or truncated are dropped when the cache is opened. All functions are safe to call from any
+ * thread, but a directory must only be opened by one cache at a time. Only available on POSIX systems.
+ */
+class DiskCache {
+public:
+	using fields_type = detail::HeaderCollector::fields_type;
+	using clock_type  = std::chrono::system_clock;
+
+	struct Record {
+		std::string key;
+		fields_type fields;
+		/// The values of the request headers named by `Vary`.
+		std::vector<std::pair<std::string, std::string>> vary;
+		clock_type::time_point expires;
+		std::size_t size;
+	};
+	struct Hit {
+		Record record;
+		/// The mapped body. Empty if the body is empty.
+		std::shared_ptr<const char> body;
+	};
+	struct Statistics {
+		std::size_t entries;
+		/// The bytes of the alive bodies.
+		std::size_t size;
+		/// The bytes of all segments including removed bodies.
+		std::size_t disk_size;
+		std::size_t segments;
+	};
+
+	/// Appends a single body to a segment. The body is discarded unless it is committed. Must not outlive the
+	/// cache.
+	class Writer {
+	public:
+		Writer(const Writer& copy) = delete;
+		Writer(Writer&& move) noexcept
+		    : _cache{ std::exchange(move._cache, nullptr) }, _segment{ move._segment }, _fd{ move._fd },
+		      _offset{ move._offset }, _size{ move._size }, _failed{ move._failed }
+		{}
+		~Writer()
+		{
+			if (_cache != nullptr) {
+				_cache->_release(*this, nullptr);
+			}
+		}
+
+		/// Appends the data. Returns `false` if writing failed, in which case the body is discarded.
+		bool write(const char* data, std::size_t size) noexcept
+		{
+			while (!_failed && size > 0) {
+				const auto written = ::pwrite(_fd, data, size, static_cast<off_t>(_offset + _size));
+				if (written < 0 && errno != EINTR) {
+					CURLIO_ERROR("Failed to write to segment " << _segment << ": " << std::strerror(errno));
+					_failed = true;
+				} else if (written > 0) {
+					data += written;
+					size -= static_cast<std::size_t>(written);
+					_size += static_cast<std::size_t>(written);
+				}
+			}
+			return !_failed;
+		}
+		/// Adds the written body under the key of the record, replacing an existing entry. The size of the
+		/// record is ignored. Returns `false` if the body could not be stored.
+		bool commit(Record record)
+		{
+			record.size = _size;
+			return std::exchange(_cache, nullptr)->_release(*this, &record);
+		}
+		std::size_t size() const noexcept { return _size; }
+
+		Writer& operator=(const Writer& copy) = delete;
+		Writer& operator=(Writer&& move)      = delete;
+
+	private:
+		friend DiskCache;
+
+		DiskCache* _cache;
+		std::uint32_t _segment;
+		int _fd;
+		std::uint64_t _offset;
+		std::uint64_t _size = 0;
+		bool _failed        = false;
+
+		Writer(DiskCache& cache, std::uint32_t segment, int fd, std::uint64_t offset) noexcept
+		    : _cache{ &cache }, _segment{ segment }, _fd{ fd }, _offset{ offset }
+		{}
+	};
+
+	/**
+	 * Opens or creates the cache in the directory. Throws `std::system_error` if it cannot be opened.
+	 *
+	 * @param max_size The budget for the alive bodies.
+	 * @param segment_size Segments take no new bodies once they reach this size.
+	 */
+	DiskCache(std::filesystem::path directory, std::size_t max_size,
+	          std::size_t segment_size = 64 * 1024 * 1024)
+	    : _directory{ std::move(directory) }, _max_size{ max_size }, _segment_size{ segment_size }
+	{
+		std::filesystem::create_directories(_directory);
+		_load();
+	}
+	DiskCache(const DiskCache& copy) = delete;
+	DiskCache(DiskCache&& move)      = delete;
+	~DiskCache()
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		_compact();
+		if (_index_fd >= 0) {
+			::close(_index_fd);
+		}
+		for (const auto& [id, segment] : _segments) {
+			::close(segment.fd);
+		}
+	}
+
+	/// Returns the entry and maps its body. Marks the entry as recently used.
+	CURLIO_NO_DISCARD std::optional<Hit> lookup(const std::string& key)
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		const auto found = _index.find(key);
+		if (found == _index.end()) {
+			return std::nullopt;
+		}
+		_entries.splice(_entries.begin(), _entries, found->second);
+		const auto& entry = *found->second;
+		Hit hit{ entry.record, {} };
+		if (entry.record.size == 0) {
+			return hit;
+		}
+
+		// Mappings must start at a page boundary.
+		static const auto page_size = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+		const auto start            = entry.offset / page_size * page_size;
+		const auto length           = static_cast<std::size_t>(entry.offset - start + entry.record.size);
+		const auto fd               = _segments.at(entry.segment).fd;
+
+		const auto address = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(start));
+		if (address == MAP_FAILED) {
+			CURLIO_ERROR("Failed to map " << key << ": " << std::strerror(errno));
+			return std::nullopt;
+		}
+		std::shared_ptr<void> mapping{ address, [length](void* address) { ::munmap(address, length); } };
+		hit.body = std::shared_ptr<const char>{ std::move(mapping),
+			                                      static_cast<const char*>(address) + (entry.offset - start) };
+		return hit;
+	}
+	/// Starts a new body. Returns nothing if no segment could be created.
+	CURLIO_NO_DISCARD std::optional<Writer> begin()
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		for (auto& [id, segment] : _segments) {
+			if (!segment.writing && segment.size < _segment_size) {
+				segment.writing = true;
+				return Writer{ *this, id, segment.fd, segment.size };
+			}
+		}
+
+		const auto id = _segments.empty() ? std::uint32_t{ 0 } : std::prev(_segments.end())->first + 1;
+		const int fd  = ::open(_segment_path(id).c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			CURLIO_ERROR("Failed to create segment " << id << ": " << std::strerror(errno));
+			return std::nullopt;
+		}
+		_segments.emplace(id, Segment{ fd, 0, 0, true });
+		return Writer{ *this, id, fd, 0 };
+	}
+	/// Replaces the fields and the expiry of the entry, e.g. after a revalidation.
+	void update(const std::string& key, fields_type fields, clock_type::time_point expires)
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		if (const auto found = _index.find(key); found != _index.end()) {
+			auto& entry          = *found->second;
+			entry.record.fields  = std::move(fields);
+			entry.record.expires = expires;
+			_append(_serialize(entry));
+		}
+	}
+	void erase(const std::string& key)
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		if (const auto found = _index.find(key); found != _index.end()) {
+			_erase(found->second, true);
+			_collect();
+		}
+	}
+	CURLIO_NO_DISCARD Statistics get_statistics() const
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		std::size_t disk_size = 0;
+		for (const auto& [id, segment] : _segments) {
+			disk_size += segment.size;
+		}
+		return { _entries.size(), _size, disk_size, _segments.size() };
+	}
+	CURLIO_NO_DISCARD const std::filesystem::path& get_directory() const noexcept { return _directory; }
+
+	DiskCache& operator=(const DiskCache& copy) = delete;
+	DiskCache& operator=(DiskCache&& move)      = delete;
+
+private:
+	constexpr static std::string_view magic = "cURLio disk cache 1\n";
+
+	struct Segment {
+		int fd;
+		std::uint64_t size;
+		/// The bytes of the alive bodies.
+		std::uint64_t alive;
+		/// Whether a writer appends to the segment.
+		bool writing;
+	};
+	struct Entry {
+		Record record;
+		std::uint32_t segment;
+		std::uint64_t offset;
+	};
+
+	std::filesystem::path _directory;
+	std::size_t _max_size;
+	std::size_t _segment_size;
+	mutable std::mutex _mutex{};
+	std::map<std::uint32_t, Segment> _segments{};
+	/// The most recently used entry first.
+	std::list<Entry> _entries{};
+	std::map<std::string, std::list<Entry>::iterator> _index{};
+	std::size_t _size = 0;
+	int _index_fd     = -1;
+	/// The records in the index log. Used to decide when to compact it.
+	std::size_t _records = 0;
+
+	std::filesystem::path _segment_path(std::uint32_t id) const
+	{
+		return _directory / ("segment-" + std::to_string(id));
+	}
+	/// Finishes the writer and adds its body if `record` is given. Returns whether the body was added.
+	bool _release(Writer& writer, Record* record)
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		auto& segment   = _segments.at(writer._segment);
+		segment.writing = false;
+		if (record == nullptr || writer._failed || writer._size > _max_size) {
+			// Nobody maps the discarded tail.
+			static_cast<void>(::ftruncate(segment.fd, static_cast<off_t>(writer._offset)));
+			_collect();
+			return false;
+		}
+
+		segment.size = writer._offset + writer._size;
+		segment.alive += writer._size;
+		if (const auto found = _index.find(record->key); found != _index.end()) {
+			_erase(found->second, false);
+		}
+		_entries.push_front(Entry{ std::move(*record), writer._segment, writer._offset });
+		_index.emplace(_entries.front().record.key, _entries.begin());
+		_size += writer._size;
+		_append(_serialize(_entries.front()));
+		while (_size > _max_size) {
+			_erase(std::prev(_entries.end()), true);
+		}
+		_collect();
+		return true;
+	}
+	void _erase(std::list<Entry>::iterator entry, bool log)
+	{
+		if (log) {
+			std::string record{ 'R' };
+			_put_string(record, entry->record.key);
+			_append(record);
+		}
+		_segments.at(entry->segment).alive -= entry->record.size;
+		_size -= entry->record.size;
+		_index.erase(entry->record.key);
+		_entries.erase(entry);
+	}
+	/// Deletes full segments which are mostly dead together with their remaining entries.
+	void _collect()
+	{
+		for (auto segment = _segments.begin(); segment != _segments.end();) {
+			if (segment->second.writing || segment->second.size < _segment_size ||
+			    segment->second.alive * 2 >= segment->second.size) {
+				++segment;
+				continue;
+			}
+
+			CURLIO_DEBUG("Deleting segment " << segment->first << " with " << segment->second.alive
+			                                 << " alive bytes");
+			for (auto entry = _entries.begin(); entry != _entries.end();) {
+				if (entry->segment == segment->first) {
+					_erase(entry++, true);
+				} else {
+					++entry;
+				}
+			}
+			// Existing mappings stay valid.
+			::close(segment->second.fd);
+			std::error_code ec{};
+			std::filesystem::remove(_segment_path(segment->first), ec);
+			segment = _segments.erase(segment);
+		}
+		if (_records > 1024 && _records > _entries.size() * 4) {
+			_compact();
+		}
+	}
+	/// Reads the index and the segments and drops everything that does not match.
+	void _load()
+	{
+		std::string content{};
+		if (const int fd = ::open((_directory / "index").c_str(), O_RDONLY | O_CLOEXEC); fd >= 0) {
+			char buffer[64 * 1024];
+			ssize_t count = 0;
+			while ((count = ::read(fd, buffer, sizeof(buffer))) > 0) {
+				content.append(buffer, static_cast<std::size_t>(count));
+			}
+			::close(fd);
+		}
+
+		std::vector<Entry> entries{};
+		std::map<std::string, std::size_t> positions{};
+		if (content.compare(0, magic.size(), magic) == 0) {
+			std::string_view input{ content };
+			input.remove_prefix(magic.size());
+			std::string_view record{};
+			while (_get_string(input, record) && !record.empty()) {
+				const char type = record.front();
+				record.remove_prefix(1);
+				std::string key{};
+				if (type == 'R' && _get_string(record, key)) {
+					positions.erase(key);
+				} else if (type == 'P') {
+					auto entry = _parse(record);
+					if (!entry.has_value()) {
+						break;
+					}
+					positions[entry->record.key] = entries.size();
+					entries.push_back(std::move(*entry));
+				} else {
+					break;
+				}
+			}
+		}
+
+		// Every segment file is listed, so that orphans are removed.
+		for (const auto& file : std::filesystem::directory_iterator{ _directory }) {
+			const auto name = file.path().filename().string();
+			std::uint32_t id = 0;
+			if (name.rfind("segment-", 0) != 0) {
+				continue;
+			} else if (const auto [end, ec] = std::from_chars(name.data() + 8, name.data() + name.size(), id);
+			           ec != std::errc{} || end != name.data() + name.size()) {
+				CURLIO_WARN("Ignoring foreign file " << file.path() << " in the disk cache");
+				continue;
+			}
+			const int fd = ::open(file.path().c_str(), O_RDWR | O_CLOEXEC);
+			struct stat status {};
+			if (fd < 0 || ::fstat(fd, &status) != 0) {
+				throw std::system_error{ errno, std::generic_category(), "failed to open " + file.path().string() };
+			}
+			_segments.emplace(id, Segment{ fd, static_cast<std::uint64_t>(status.st_size), 0, false });
+		}
+
+		// Restore the order of use; the log lists the least recently used entry first.
+		std::vector<std::pair<std::size_t, std::string>> order{};
+		for (const auto& [key, position] : positions) {
+			order.emplace_back(position, key);
+		}
+		std::sort(order.begin(), order.end());
+		for (auto& [position, key] : order) {
+			auto& entry        = entries[position];
+			const auto segment = _segments.find(entry.segment);
+			if (segment == _segments.end() || entry.offset + entry.record.size > segment->second.size) {
+				CURLIO_WARN("Dropping " << key << " from the disk cache because its segment is damaged");
+				continue;
+			}
+			segment->second.alive += entry.record.size;
+			_size += entry.record.size;
+			_entries.push_front(std::move(entry));
+			_index.emplace(std::move(key), _entries.begin());
+		}
+		for (auto segment = _segments.begin(); segment != _segments.end();) {
+			if (segment->second.alive == 0) {
+				::close(segment->second.fd);
+				std::filesystem::remove(_segment_path(segment->first));
+				segment = _segments.erase(segment);
+			} else {
+				++segment;
+			}
+		}
+
+		while (_size > _max_size) {
+			_erase(std::prev(_entries.end()), false);
+		}
+		_compact();
+		if (_index_fd < 0) {
+			throw std::system_error{ errno, std::generic_category(), "failed to write the disk cache index" };
+		}
+		CURLIO_INFO("Opened disk cache with " << _entries.size() << " entries and " << _size << " bytes");
+	}
+	/// Rewrites the index with one record per entry in the order of use.
+	void _compact()
+	{
+		std::string content{ magic };
+		for (auto entry = _entries.rbegin(); entry != _entries.rend(); ++entry) {
+			_put_string(content, _serialize(*entry));
+		}
+
+		const auto path      = _directory / "index";
+		const auto temporary = _directory / "index.tmp";
+		const int fd         = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		const bool written   = fd >= 0 && _write_all(fd, content) && ::fsync(fd) == 0;
+		if (fd >= 0) {
+			::close(fd);
+		}
+		if (!written || ::rename(temporary.c_str(), path.c_str()) != 0) {
+			CURLIO_ERROR("Failed to compact the disk cache index: " << std::strerror(errno));
+			return;
+		}
+
+		if (_index_fd >= 0) {
+			::close(_index_fd);
+		}
+		_index_fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+		_records  = _entries.size();
+	}
+	void _append(const std::string& record)
+	{
+		std::string framed{};
+		_put_string(framed, record);
+		if (_index_fd < 0 || !_write_all(_index_fd, framed)) {
+			CURLIO_ERROR("Failed to append to the disk cache index");
+		}
+		++_records;
+	}
+	static bool _write_all(int fd, std::string_view data) noexcept
+	{
+		while (!data.empty()) {
+			const auto written = ::write(fd, data.data(), data.size());
+			if (written < 0 && errno != EINTR) {
+				return false;
+			} else if (written > 0) {
+				data.remove_prefix(static_cast<std::size_t>(written));
+			}
+		}
+		return true;
+	}
+	static std::string _serialize(const Entry& entry)
+	{
+		std::string record{ 'P' };
+		_put_integer(record, entry.segment);
+		_put_integer(record, entry.offset);
+		_put_integer(record, entry.record.size);
+		const auto expires =
+		  std::chrono::duration_cast<std::chrono::seconds>(entry.record.expires.time_since_epoch()).count();
+		_put_integer(record, static_cast<std::uint64_t>(std::max<std::int64_t>(expires, 0)));
+		_put_string(record, entry.record.key);
+		_put_integer(record, entry.record.fields.size());
+		for (const auto& [key, value] : entry.record.fields) {
+			_put_string(record, key);
+			_put_string(record, value);
+		}
+		_put_integer(record, entry.record.vary.size());
+		for (const auto& [key, value] : entry.record.vary) {
+			_put_string(record, key);
+			_put_string(record, value);
+		}
+		return record;
+	}
+	static std::optional<Entry> _parse(std::string_view record)
+	{
+		Entry entry{};
+		std::uint64_t segment = 0;
+		std::uint64_t size    = 0;
+		std::uint64_t expires = 0;
+		std::uint64_t count   = 0;
+		if (!_get_integer(record, segment) || !_get_integer(record, entry.offset) ||
+		    !_get_integer(record, size) || !_get_integer(record, expires) ||
+		    !_get_string(record, entry.record.key) || !_get_integer(record, count)) {
+			return std::nullopt;
+		}
+		entry.segment        = static_cast<std::uint32_t>(segment);
+		entry.record.size    = static_cast<std::size_t>(size);
+		entry.record.expires = clock_type::time_point{ std::chrono::seconds{ expires } };
+		for (std::string key, value; count > 0; --count) {
+			if (!_get_string(record, key) || !_get_string(record, value)) {
+				return std::nullopt;
+			}
+			entry.record.fields.emplace(std::move(key), std::move(value));
+		}
+		if (!_get_integer(record, count)) {
+			return std::nullopt;
+		}
+		for (std::string key, value; count > 0; --count) {
+			if (!_get_string(record, key) || !_get_string(record, value)) {
+				return std::nullopt;
+			}
+			entry.record.vary.emplace_back(std::move(key), std::move(value));
+		}
+		return entry;
+	}
+	/// Appends the integer in LEB128.
+	static void _put_integer(std::string& output, std::uint64_t value)
+	{
+		do {
+			output.push_back(static_cast<char>((value & 0x7f) | (value > 0x7f ? 0x80 : 0)));
+			value >>= 7;
+		} while (value > 0);
+	}
+	static void _put_string(std::string& output, std::string_view value)
+	{
+		_put_integer(output, value.size());
+		output.append(value);
+	}
+	static bool _get_integer(std::string_view& input, std::uint64_t& value) noexcept
+	{
+		value = 0;
+		for (unsigned shift = 0; !input.empty() && shift < 64; shift += 7) {
+			const auto byte = static_cast<unsigned char>(input.front());
+			input.remove_prefix(1);
+			value |= std::uint64_t{ byte & 0x7fu } << shift;
+			if ((byte & 0x80) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+	template<typename String>
+	static bool _get_string(std::string_view& input, String& value)
+	{
+		std::uint64_t size = 0;
+		if (!_get_integer(input, size) || size > input.size()) {
+			return false;
+		}
+		value = String{ input.substr(0, static_cast<std::size_t>(size)) };
+		input.remove_prefix(static_cast<std::size_t>(size));
+		return true;
+	}
+};
+
+} // namespace cURLio
+
+#endif
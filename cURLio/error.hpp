@@ -22,11 +22,16 @@ enum class Code {
 	request_not_active,
 	bad_url,
 	no_response_code,
+	unsupported_share_data,
+	bad_range_response,
+	unsuccessful_status,
 
 	/// From 1000 - 2000 reserved for CURL easy errors.
 	curl_easy_reserved = 1000,
 	/// From 2000 - 3000 reserved for CURL easy errors.
 	curl_multi_reserved = 2000,
+	/// From 3000 - 4000 reserved for CURL share errors.
+	curl_share_reserved = 3000,
 };
 
 enum class Condition {
@@ -34,6 +39,7 @@ enum class Condition {
 	usage,
 	curl_easy,
 	curl_multi,
+	curl_share,
 };
 
 std::error_condition make_error_condition(Condition condition) noexcept;
@@ -53,6 +59,8 @@ inline const std::error_category& code_category() noexcept
 				return make_error_condition(Condition::curl_easy);
 			} else if (code >= 2000 && code < 3000) {
 				return make_error_condition(Condition::curl_multi);
+			} else if (code >= 3000 && code < 4000) {
+				return make_error_condition(Condition::curl_share);
 			}
 			return error_category::default_error_condition(code);
 		}
@@ -63,6 +71,8 @@ inline const std::error_category& code_category() noexcept
 				return curl_easy_strerror(static_cast<CURLcode>(ec - 1000));
 			} else if (ec >= 2000 && ec < 3000) {
 				return curl_multi_strerror(static_cast<CURLMcode>(ec - 2000 - 1));
+			} else if (ec >= 3000 && ec < 4000) {
+				return curl_share_strerror(static_cast<CURLSHcode>(ec - 3000));
 			}
 
 			switch (static_cast<Code>(ec)) {
@@ -76,6 +86,9 @@ inline const std::error_category& code_category() noexcept
 			case Code::request_not_active: return "request is not active";
 			case Code::bad_url: return "bad URL";
 			case Code::no_response_code: return "no response code available";
+			case Code::unsupported_share_data: return "data cannot be shared between sessions";
+			case Code::bad_range_response: return "range request not answered with the requested part";
+			case Code::unsuccessful_status: return "request not answered with a successful status";
 
 			default: return "(unrecognized error code)";
 			}
@@ -95,6 +108,7 @@ inline const std::error_category& condition_category() noexcept
 			case Condition::success: return "success";
 			case Condition::usage: return "usage";
 			case Condition::curl_easy: return "CURL easy";
+			case Condition::curl_share: return "CURL share";
 			default: return "(unrecognized error condition)";
 			}
 		}
@@ -6,10 +6,22 @@ namespace cURLio
 template<typename Executor>
 class BasicSession;
 
+template<typename Executor>
+class BasicSessionPool;
+
+template<typename Executor>
+class BasicCachingSession;
+
+template<typename Executor>
+class BasicResolver;
+
 template<typename Executor>
 class BasicRequest;
 
 template<typename Executor>
 class BasicResponse;
 
+template<typename Mutex>
+class BasicShare;
+
 }
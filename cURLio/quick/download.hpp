@@ -0,0 +1,69 @@
+/**
+ * @file
+ *
+ * Convenience function to write the response body to a file.
+ */
+#pragma once
+
+#include "../basic_response.hpp"
+#include "../detail/file_writer.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#if !defined(_WIN32)
+
+namespace cURLio::quick {
+
+using DownloadOptions = detail::FileWriter::Options;
+
+struct DownloadResult {
+	/// The bytes of the body which reached the file.
+	std::uint64_t bytes_written;
+	/// Whether the file was flushed with `fsync()`.
+	bool synced;
+};
+
+/**
+ * Writes the response body to the file at `path`. The data is written from within the write callback of cURL
+ * (see `BasicResponse::async_drain()`), hence it is neither buffered by the response nor passed through the
+ * strand a second time. Unless `direct` or `io_uring` is set, every chunk is written with `pwrite()` without
+ * copying it. A failed write aborts the transfer and is reported instead of the error of cURL. The handler
+ * signature is `void(error_code, DownloadResult)`. The last writes and the `fsync()` block the thread which
+ * completes the operation. Only available on POSIX systems.
+ */
+template<typename Executor>
+inline auto async_download_to_file(std::shared_ptr<BasicResponse<Executor>> response,
+                                   const std::filesystem::path& path, DownloadOptions options, auto&& token)
+{
+	auto executor = response->get_executor();
+	return CURLIO_ASIO_NS::async_compose<decltype(token), void(detail::asio_error_code, DownloadResult)>(
+	  [response = std::move(response), writer = std::make_shared<detail::FileWriter>(), path, options,
+	   started = false](auto& self, detail::asio_error_code ec = {}, std::size_t /* size */ = 0) mutable {
+		  if (!std::exchange(started, true)) {
+			  // Opened only once the operation runs, since deferred operations might never be started.
+			  if (const auto open_error = writer->open(path, options); open_error) {
+				  auto executor = response->get_executor();
+				  CURLIO_ASIO_NS::post(std::move(executor), std::bind(std::move(self), open_error, std::size_t{ 0 }));
+			  } else {
+				  response->async_drain(
+				    [writer](const char* data, std::size_t size) { return writer->write(data, size); },
+				    std::move(self));
+			  }
+			  return;
+		  }
+
+		  if (const auto finish_error = writer->finish(options.sync && !ec); !ec) {
+			  ec = finish_error;
+		  }
+		  self.complete(ec, DownloadResult{ writer->written(), writer->synced() });
+	  },
+	  token, std::move(executor));
+}
+
+} // namespace cURLio::quick
+
+#endif
@@ -0,0 +1,377 @@
+/**
+ * @file
+ *
+ * Convenience function to download a large object over multiple connections.
+ */
+#pragma once
+
+#include "../basic_request.hpp"
+#include "../basic_response.hpp"
+#include "../basic_session.hpp"
+#include "../detail/file_writer.hpp"
+#include "../detail/function.hpp"
+#include "../error.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#	include <fcntl.h>
+#	include <unistd.h>
+
+namespace cURLio::quick {
+
+struct ParallelDownloadResult {
+	/// The bytes of the body which reached the file.
+	std::uint64_t bytes_written;
+	/// The requests for parts of the body, including the ones for stolen work and resumed parts.
+	std::size_t requests;
+	/// How often the rest of a running part was split off for a connection which finished its own part.
+	std::size_t steals;
+};
+
+} // namespace cURLio::quick
+
+namespace cURLio::detail {
+
+/// The state of `quick::async_parallel_download()`. Only accessed on the strand of the session.
+template<typename Executor>
+class ParallelDownload : public std::enable_shared_from_this<ParallelDownload<Executor>> {
+public:
+	using request_pointer  = std::shared_ptr<BasicRequest<Executor>>;
+	using response_pointer = std::shared_ptr<BasicResponse<Executor>>;
+	using handler_type     = Function<void(asio_error_code, quick::ParallelDownloadResult)>;
+
+	/// Parts below twice this size are not split anymore.
+	constexpr static std::uint64_t min_split = 1024 * 1024;
+
+	ParallelDownload(BasicSession<Executor>& session, request_pointer prototype, std::filesystem::path path,
+	                 std::size_t segments, handler_type handler)
+	    : _session{ session }, _prototype{ std::move(prototype) }, _path{ std::move(path) },
+	      _segments{ std::max<std::size_t>(segments, 1) }, _handler{ std::move(handler) }
+	{}
+
+	/// Asks for the size of the object with a `HEAD` request.
+	void start()
+	{
+		auto head = std::make_shared<BasicRequest<Executor>>(*_prototype);
+		head->template set_option<CURLOPT_NOBODY>(1L);
+		_session.async_start(head, _bind([self = this->shared_from_this(), head](asio_error_code ec,
+		                                                                         response_pointer response) {
+			if (ec) {
+				self->_complete(ec);
+				return;
+			}
+			async_wait_last_headers(response, self->_bind([self, head, response](asio_error_code ec, auto headers) {
+				self->_on_head(ec, head, response, std::move(headers));
+			}));
+		}));
+	}
+
+private:
+	struct Part {
+		std::uint64_t begin;
+		/// The position of the next byte to write.
+		std::uint64_t position;
+		/// Shrinks when the rest is stolen.
+		std::uint64_t end;
+		std::unique_ptr<FileWriter> writer{};
+		request_pointer request{};
+		response_pointer response{};
+		bool running = false;
+		/// Whether the status was checked.
+		bool checked = false;
+	};
+
+	BasicSession<Executor>& _session;
+	request_pointer _prototype;
+	std::filesystem::path _path;
+	std::size_t _segments;
+	handler_type _handler;
+	/// Whether the server answers range requests. Otherwise a single part of unknown size is downloaded.
+	bool _ranged = false;
+	std::vector<std::unique_ptr<Part>> _parts{};
+	std::size_t _running = 0;
+	std::size_t _requests = 0;
+	std::size_t _steals   = 0;
+	/// The first error, which stops all parts.
+	asio_error_code _error{};
+
+	/// Lets the handler run on the strand of the session.
+	auto _bind(auto handler)
+	{
+		return CURLIO_ASIO_NS::bind_executor(_session.get_strand(), std::move(handler));
+	}
+
+	void _on_head(asio_error_code ec, const request_pointer& head, response_pointer response,
+	              HeaderCollector::fields_type headers)
+	{
+		if (ec) {
+			_complete(ec);
+			return;
+		}
+
+		// Some servers refuse `HEAD`, the object might still be there.
+		long status = 0;
+		curl_easy_getinfo(head->native_handle(), CURLINFO_RESPONSE_CODE, &status);
+		const auto ranges = headers.find("accept-ranges");
+		_ranged           = status / 100 == 2 && ranges != headers.end() &&
+		          ranges->second.find("bytes") != std::string::npos;
+		response->template async_get_info<CURLINFO_CONTENT_LENGTH_DOWNLOAD_T>(
+		  _bind([self = this->shared_from_this(), response](asio_error_code ec, curl_off_t length) {
+			  if (ec) {
+				  self->_complete(ec);
+			  } else {
+				  self->_split(length);
+			  }
+		  }));
+	}
+	/// Creates the file and starts the parts.
+	void _split(curl_off_t length)
+	{
+		const int fd = ::open(_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			_complete({ errno, CURLIO_ASIO_NS::error::get_system_category() });
+			return;
+		}
+		// Reserves the space up front, so that the parts do not fragment the file.
+		if (length > 0) {
+			if (const int err = ::posix_fallocate(fd, 0, length); err != 0 && ::ftruncate(fd, length) != 0) {
+				CURLIO_WARN("Failed to preallocate " << _path << ": " << std::strerror(err));
+			}
+		}
+		::close(fd);
+
+		if (length < 0 || !_ranged) {
+			CURLIO_DEBUG("Downloading " << _path << " over one connection");
+			_ranged = false;
+			_launch(0, std::numeric_limits<std::uint64_t>::max());
+		} else {
+			const auto size  = static_cast<std::uint64_t>(length);
+			const auto count = std::min<std::uint64_t>(_segments, std::max<std::uint64_t>(size / min_split, 1));
+			for (std::uint64_t i = 0; i < count && size > 0 && !_error; ++i) {
+				_launch(size * i / count, size * (i + 1) / count);
+			}
+		}
+		if (_running == 0) {
+			_complete(_error);
+		}
+	}
+	/// Starts a request for the part. Sets the error if the part could not be started.
+	void _launch(std::uint64_t begin, std::uint64_t end)
+	{
+		auto& part  = *_parts.emplace_back(new Part{ begin, begin, end });
+		part.writer = std::make_unique<FileWriter>();
+		FileWriter::Options options{};
+		options.offset   = begin;
+		options.truncate = false;
+		if (const auto ec = part.writer->open(_path, options); ec) {
+			_fail(ec);
+			return;
+		}
+		part.running = true;
+		++_running;
+		++_requests;
+
+		part.request = std::make_shared<BasicRequest<Executor>>(*_prototype);
+		if (_ranged) {
+			part.request->template set_option<CURLOPT_RANGE>(
+			  (std::to_string(begin) + "-" + std::to_string(end - 1)).c_str());
+		}
+		_session.async_start(part.request, _bind([self = this->shared_from_this(), &part](
+		                                           asio_error_code ec, response_pointer response) {
+			if (ec || self->_error) {
+				self->_finish_part(part, ec ? ec : CURLIO_ASIO_NS::error::operation_aborted);
+				return;
+			}
+			part.response = std::move(response);
+			part.response->async_drain(
+			  [self, &part](const char* data, std::size_t size) { return self->_write(part, data, size); },
+			  self->_bind([self, &part](asio_error_code ec, std::size_t /* size */) {
+				  // The part might have been aborted while the completion was queued.
+				  if (part.running) {
+					  self->_finish_part(part, ec);
+				  }
+			  }));
+		}));
+	}
+	/// The sink of a part. Aborts the transfer once the part is written.
+	asio_error_code _write(Part& part, const char* data, std::size_t size)
+	{
+		if (_error) {
+			return CURLIO_ASIO_NS::error::operation_aborted;
+		} else if (!part.checked) {
+			if (const auto ec = _check(part); ec) {
+				return ec;
+			}
+		}
+
+		const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(size, part.end - part.position));
+		if (const auto ec = part.writer->write(data, count); ec) {
+			return ec;
+		}
+		part.position += count;
+		return count < size ? CURLIO_ASIO_NS::error::operation_aborted : asio_error_code{};
+	}
+	/// Checks the status once the part received its headers.
+	asio_error_code _check(Part& part)
+	{
+		part.checked = true;
+		long status  = 0;
+		curl_easy_getinfo(part.request->native_handle(), CURLINFO_RESPONSE_CODE, &status);
+		if (_ranged && status != 206) {
+			CURLIO_WARN("Range request of " << _path << " answered with status " << status);
+			return make_error_code(Code::bad_range_response);
+		} else if (!_ranged && status / 100 != 2) {
+			CURLIO_WARN("Request of " << _path << " answered with status " << status);
+			return make_error_code(Code::unsuccessful_status);
+		}
+		return {};
+	}
+	void _finish_part(Part& part, asio_error_code ec)
+	{
+		// An empty body never reached the sink.
+		if (!ec && !part.checked && part.request != nullptr) {
+			ec = _check(part);
+		}
+		part.running = false;
+		--_running;
+		if (const auto finish_error = part.writer->finish(false); finish_error && !ec) {
+			ec = finish_error;
+		}
+		part.request.reset();
+		part.response.reset();
+
+		const bool done = _ranged ? part.position >= part.end : !ec;
+		if (done) {
+			if (!_error && _ranged) {
+				_steal();
+			}
+		} else if (!_error) {
+			// The transfer ended early, but made progress: the rest is requested again.
+			if (_ranged && !ec && part.position > part.begin) {
+				CURLIO_DEBUG("Resuming part of " << _path << " at " << part.position);
+				_launch(part.position, part.end);
+			} else {
+				_fail(ec ? ec : make_error_code(Code::bad_range_response));
+			}
+		}
+		if (_running == 0) {
+			_complete(_error);
+		}
+	}
+	/// Sets the error and aborts the transfers of the other parts by releasing their responses. Starts which
+	/// still wait for the limits of the session are aborted, other parts which are still starting are stopped
+	/// once their response arrives.
+	void _fail(asio_error_code ec)
+	{
+		_error = ec;
+		for (const auto& part : _parts) {
+			if (!part->running) {
+				continue;
+			} else if (part->response == nullptr) {
+				_session.abort_waiting(part->request);
+				continue;
+			}
+			part->running = false;
+			--_running;
+			// The first error is reported, later ones of the aborted parts are only logged.
+			if (const auto finish_error = part->writer->finish(false); finish_error) {
+				CURLIO_WARN("Failed to write part of " << _path << ": " << finish_error.message());
+			}
+			part->response.reset();
+			part->request.reset();
+		}
+	}
+	/// Splits the running part with the largest rest and downloads its second half over a new connection.
+	void _steal()
+	{
+		Part* victim = nullptr;
+		for (const auto& part : _parts) {
+			const auto rest = part->end - part->position;
+			if (part->running && (victim == nullptr || rest > victim->end - victim->position)) {
+				victim = part.get();
+			}
+		}
+		if (victim == nullptr || victim->end - victim->position < 2 * min_split) {
+			return;
+		}
+
+		const auto middle = victim->position + (victim->end - victim->position) / 2;
+		const auto end    = std::exchange(victim->end, middle);
+		++_steals;
+		CURLIO_DEBUG("Stealing " << middle << "-" << end << " of " << _path);
+		_launch(middle, end);
+	}
+	void _complete(asio_error_code ec)
+	{
+		if (!_handler) {
+			return;
+		}
+		std::uint64_t written = 0;
+		for (const auto& part : _parts) {
+			written += part->writer->written();
+		}
+		std::exchange(_handler, {})(ec, quick::ParallelDownloadResult{ written, _requests, _steals });
+	}
+};
+
+} // namespace cURLio::detail
+
+namespace cURLio::quick {
+
+/**
+ * Downloads the object of the prototype into the file at `path` over `segments` connections at the same
+ * time. The size and the support for ranges are asked for with a `HEAD` request. Then the file is
+ * preallocated and split into `segments` equal parts of at least 1 MiB. The parts are requested with copies
+ * of the prototype and written with `pwrite()` to their position (see `async_download_to_file()`). A
+ * connection which finished its part takes over the second half of the largest remaining part, so that a
+ * slow connection does not hold up the end. Parts which end early are requested again from where they
+ * stopped. Without range support or a known size the object is downloaded over one connection, which must
+ * answer with a successful status. The first error aborts all parts. The handler signature is
+ * `void(error_code, ParallelDownloadResult)`. Only available on POSIX systems.
+ */
+template<typename Executor>
+inline auto async_parallel_download(BasicSession<Executor>& session,
+                                    std::shared_ptr<BasicRequest<Executor>> prototype,
+                                    const std::filesystem::path& path, std::size_t segments, auto&& token)
+{
+	using signature = void(detail::asio_error_code, ParallelDownloadResult);
+	return CURLIO_ASIO_NS::async_initiate<decltype(token), signature>(
+	  [&session](auto handler, std::shared_ptr<BasicRequest<Executor>> prototype, std::filesystem::path path,
+	             std::size_t segments) {
+		  auto executor = CURLIO_ASIO_NS::get_associated_executor(handler, session.get_executor());
+		  auto download = std::make_shared<detail::ParallelDownload<Executor>>(
+		    session, std::move(prototype), std::move(path), segments,
+		    [executor = std::move(executor), handler = std::move(handler)](
+		      detail::asio_error_code ec, ParallelDownloadResult result) mutable {
+			    CURLIO_ASIO_NS::post(std::move(executor), std::bind(std::move(handler), ec, result));
+		    });
+		  CURLIO_ASIO_NS::dispatch(session.get_strand(), [download] { download->start(); });
+	  },
+	  token, std::move(prototype), path, segments);
+}
+
+/// Like above but with a plain `GET` request for the URL as prototype.
+template<typename Executor>
+inline auto async_parallel_download(BasicSession<Executor>& session, const std::string& url,
+                                    const std::filesystem::path& path, std::size_t segments, auto&& token)
+{
+	auto prototype = std::make_shared<BasicRequest<Executor>>(session);
+	prototype->template set_option<CURLOPT_URL>(url.c_str());
+	return async_parallel_download(session, std::move(prototype), path, segments,
+	                               std::forward<decltype(token)>(token));
+}
+
+} // namespace cURLio::quick
+
+#endif
@@ -1,7 +1,7 @@
 /**
  * @file
  *
- * Convenience function to read all the response body to a `std::string`.
+ * Convenience functions to read all the response body to a `std::string` or a `BufferChain`.
  */
 #pragma once
 
@@ -9,10 +9,155 @@
 #include "../error.hpp"
 #include "../debug.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace cURLio::quick {
 
+/**
+ * A body kept in a list of chunks which never move once allocated. Every chunk is twice as large as the one
+ * before, up to `max_chunk_size`, so a body of n bytes takes O(log n) allocations and nothing read before is
+ * copied again. The chunks are allocated with `Allocator` rebound to `char`. Models an ASIO
+ * `ConstBufferSequence` of the filled parts.
+ */
+template<typename Allocator = std::allocator<char>>
+class BufferChain {
+	using traits_type = typename std::allocator_traits<Allocator>::template rebind_traits<char>;
+
+	struct Chunk {
+		char* data;
+		std::size_t capacity;
+	};
+
+public:
+	using allocator_type = typename traits_type::allocator_type;
+	using value_type     = CURLIO_ASIO_NS::const_buffer;
+	using const_iterator = typename std::vector<value_type>::const_iterator;
+
+	constexpr static std::size_t first_chunk_size = 4096;
+	constexpr static std::size_t max_chunk_size   = 4 * 1024 * 1024;
+
+	explicit BufferChain(const Allocator& allocator = {}) noexcept : _allocator{ allocator } {}
+	BufferChain(const BufferChain& copy) = delete;
+	BufferChain(BufferChain&& move) noexcept
+	    : _allocator{ move._allocator }, _chunks{ std::exchange(move._chunks, {}) },
+	      _buffers{ std::exchange(move._buffers, {}) }, _size{ std::exchange(move._size, 0) },
+	      _free{ std::exchange(move._free, 0) }
+	{}
+	~BufferChain() { _clear(); }
+
+	CURLIO_NO_DISCARD const_iterator begin() const noexcept { return _buffers.begin(); }
+	CURLIO_NO_DISCARD const_iterator end() const noexcept { return _buffers.end(); }
+	/// The number of bytes in the chain.
+	CURLIO_NO_DISCARD std::size_t size() const noexcept { return _size; }
+	CURLIO_NO_DISCARD bool empty() const noexcept { return _size == 0; }
+	CURLIO_NO_DISCARD std::size_t chunk_count() const noexcept { return _chunks.size(); }
+	CURLIO_NO_DISCARD allocator_type get_allocator() const noexcept { return _allocator; }
+	/// Returns the free space at the end of the last chunk. Adds the next chunk if the last one is full.
+	CURLIO_ASIO_NS::mutable_buffer prepare()
+	{
+		if (_free == 0) {
+			_add(_chunks.empty() ? first_chunk_size : std::min(_chunks.back().capacity * 2, max_chunk_size));
+		}
+		const auto& chunk = _chunks.back();
+		return { chunk.data + chunk.capacity - _free, _free };
+	}
+	/// Appends `size` bytes written to the space returned by `prepare()`.
+	void commit(std::size_t size) noexcept
+	{
+		size         = std::min(size, _free);
+		auto& buffer = _buffers.back();
+		buffer       = { buffer.data(), buffer.size() + size };
+		_size += size;
+		_free -= size;
+	}
+	/// Makes sure that the next `size` bytes fit into one chunk, for example once the length of the body is
+	/// known.
+	void reserve(std::size_t size)
+	{
+		if (_free < size) {
+			_add(size);
+		}
+	}
+	/// Copies the chain into one string.
+	CURLIO_NO_DISCARD std::string to_string() const
+	{
+		std::string result(_size, '\0');
+		CURLIO_ASIO_NS::buffer_copy(CURLIO_ASIO_NS::buffer(result), _buffers);
+		return result;
+	}
+
+	BufferChain& operator=(const BufferChain& copy) = delete;
+	BufferChain& operator=(BufferChain&& move) noexcept
+	{
+		if (this != &move) {
+			_clear();
+			_allocator = move._allocator;
+			_chunks    = std::exchange(move._chunks, {});
+			_buffers   = std::exchange(move._buffers, {});
+			_size      = std::exchange(move._size, 0);
+			_free      = std::exchange(move._free, 0);
+		}
+		return *this;
+	}
+
+private:
+	allocator_type _allocator;
+	std::vector<Chunk> _chunks{};
+	/// The filled part of every chunk.
+	std::vector<value_type> _buffers{};
+	std::size_t _size = 0;
+	/// The free space of the last chunk.
+	std::size_t _free = 0;
+
+	void _add(std::size_t capacity)
+	{
+		_chunks.reserve(_chunks.size() + 1);
+		_buffers.reserve(_buffers.size() + 1);
+		const auto data = traits_type::allocate(_allocator, capacity);
+		_chunks.push_back({ data, capacity });
+		_buffers.emplace_back(data, 0);
+		_free = capacity;
+	}
+	void _clear() noexcept
+	{
+		for (const auto& chunk : _chunks) {
+			traits_type::deallocate(_allocator, chunk.data, chunk.capacity);
+		}
+		_chunks.clear();
+		_buffers.clear();
+		_size = 0;
+		_free = 0;
+	}
+};
+
+} // namespace cURLio::quick
+
+namespace cURLio::detail {
+
+/// The steps of `quick::async_read_all()`.
+enum class ReadAllStep {
+	start,
+	first_read,
+	/// Asks for the content length, which is known once the first data arrived.
+	measure,
+	read,
+};
+
+} // namespace cURLio::detail
+
+namespace cURLio::quick {
+
+/**
+ * Reads the whole body into a string which grows by at least `buffer_increment` bytes per read. Once the
+ * first data arrived, the string is sized to the content length if the server sent one. Bodies of unknown
+ * length are copied whenever the string reallocates; see `async_read_all_chain()` for large ones. The
+ * handler signature is `void(error_code, std::string)`.
+ */
 template<typename Executor>
 inline auto async_read_all(std::shared_ptr<BasicResponse<Executor>> response, auto&& token,
                            std::size_t buffer_increment = 4096)
@@ -20,29 +165,85 @@ inline auto async_read_all(std::shared_ptr<BasicResponse<Executor>> response, au
 	auto executor = response->get_executor();
 	return CURLIO_ASIO_NS::async_compose<decltype(token), void(detail::asio_error_code, std::string)>(
 	  [response = std::move(response), buffer_increment, last_buffer_size = std::size_t{ 0 },
-	   buffer = std::string{}](auto& self, const detail::asio_error_code& ec = {},
-	                           std::size_t bytes_transferred = 0) mutable {
-		  last_buffer_size += bytes_transferred;
-		  if (ec || ec == CURLIO_ASIO_NS::error::eof) {
-			  buffer.resize(last_buffer_size);
-			  self.complete(ec == CURLIO_ASIO_NS::error::eof ? detail::asio_error_code{} : ec, std::move(buffer));
-		  } else {
-			  // Initial call.
-			  if (curl_off_t length;
-			      bytes_transferred == 0 &&
-			      (length = response->template get_info<CURLINFO_CONTENT_LENGTH_DOWNLOAD_T>()) >= 0) {
+	   buffer = std::string{}, step = detail::ReadAllStep::start](
+	    auto& self, const detail::asio_error_code& ec = {}, std::size_t value = 0) mutable {
+		  using detail::ReadAllStep;
+		  switch (const auto previous = std::exchange(step, ReadAllStep::read); previous) {
+		  case ReadAllStep::start: step = ReadAllStep::first_read; break;
+		  case ReadAllStep::first_read:
+		  case ReadAllStep::read:
+			  last_buffer_size += value;
+			  if (ec) {
+				  buffer.resize(last_buffer_size);
+				  self.complete(ec == CURLIO_ASIO_NS::error::eof ? detail::asio_error_code{} : ec, std::move(buffer));
+				  return;
+			  } else if (previous == ReadAllStep::first_read) {
+				  step = ReadAllStep::measure;
+				  response->template async_get_info<CURLINFO_CONTENT_LENGTH_DOWNLOAD_T>(std::move(self));
+				  return;
+			  }
+			  break;
+		  case ReadAllStep::measure:
+			  // The length is -1 if unknown.
+			  if (const auto length = static_cast<curl_off_t>(value);
+			      !ec && length > 0 && static_cast<std::size_t>(length) > buffer.size()) {
 				  buffer.resize(static_cast<std::size_t>(length));
 			  }
+			  break;
+		  }
 
-			  // Always make sure at least buffer_increment is available.
-			  if (buffer.size() - last_buffer_size < buffer_increment) {
-				  buffer.resize(last_buffer_size + buffer_increment);
-			  }
+		  // Always make sure at least buffer_increment is available.
+		  if (buffer.size() - last_buffer_size < buffer_increment) {
+			  buffer.resize(last_buffer_size + buffer_increment);
+		  }
 
-			  response->async_read_some(
-			    CURLIO_ASIO_NS::buffer(buffer.data() + last_buffer_size, buffer.size() - last_buffer_size),
-			    std::move(self));
+		  response->async_read_some(
+		    CURLIO_ASIO_NS::buffer(buffer.data() + last_buffer_size, buffer.size() - last_buffer_size),
+		    std::move(self));
+	  },
+	  token, std::move(executor));
+}
+
+/**
+ * Reads the whole body into a `BufferChain` allocating with `allocator`. Unlike `async_read_all()` data is
+ * never copied again after it was read, and the chunks grow geometrically, so the reads get larger with the
+ * body. Once the first data arrived, the rest of the content length is reserved in one chunk if the server
+ * sent one. The handler signature is `void(error_code, BufferChain<Allocator>)`.
+ */
+template<typename Executor, typename Allocator = std::allocator<char>>
+inline auto async_read_all_chain(std::shared_ptr<BasicResponse<Executor>> response, auto&& token,
+                                 const Allocator& allocator = {})
+{
+	using chain_type = BufferChain<Allocator>;
+	auto executor    = response->get_executor();
+	return CURLIO_ASIO_NS::async_compose<decltype(token), void(detail::asio_error_code, chain_type)>(
+	  [response = std::move(response), chain = chain_type{ allocator }, step = detail::ReadAllStep::start](
+	    auto& self, const detail::asio_error_code& ec = {}, std::size_t value = 0) mutable {
+		  using detail::ReadAllStep;
+		  switch (const auto previous = std::exchange(step, ReadAllStep::read); previous) {
+		  case ReadAllStep::start: step = ReadAllStep::first_read; break;
+		  case ReadAllStep::first_read:
+		  case ReadAllStep::read:
+			  chain.commit(value);
+			  if (ec) {
+				  self.complete(ec == CURLIO_ASIO_NS::error::eof ? detail::asio_error_code{} : ec, std::move(chain));
+				  return;
+			  } else if (previous == ReadAllStep::first_read) {
+				  step = ReadAllStep::measure;
+				  response->template async_get_info<CURLINFO_CONTENT_LENGTH_DOWNLOAD_T>(std::move(self));
+				  return;
+			  }
+			  break;
+		  case ReadAllStep::measure:
+			  // The length is -1 if unknown. One more byte lets the last read see the end without another chunk.
+			  if (const auto length = static_cast<curl_off_t>(value);
+			      !ec && length > 0 && static_cast<std::size_t>(length) > chain.size()) {
+				  chain.reserve(static_cast<std::size_t>(length) - chain.size() + 1);
+			  }
+			  break;
 		  }
+
+		  response->async_read_some(chain.prepare(), std::move(self));
 	  },
 	  token, std::move(executor));
 }
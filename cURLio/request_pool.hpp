@@ -0,0 +1,143 @@
+/**
+ * @file
+ *
+ * Recycling of the easy handles of requests.
+ */
+#pragma once
+
+#include "config.hpp"
+#include "debug.hpp"
+#include "detail/option_type.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <curl/curl.h>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace cURLio {
+
+/**
+ * Keeps the easy handles of destroyed requests and hands them to new requests instead of creating fresh ones.
+ * Returned handles are cleared with `curl_easy_reset()`, which resets all options but keeps the allocated
+ * buffers of the handle. What is saved is the allocation and the setup of a handle, not connections: the
+ * transfers of a session run through its multi handle, which owns the connection pool and the DNS cache for
+ * all of them anyway. Afterwards the base options are applied, so that new requests start with them already
+ * set. All functions are safe to call from any thread. A session with a pool (see
+ * `BasicSession::set_request_pool()`) creates all its requests from it.
+ */
+class RequestPool {
+public:
+	struct Statistics {
+		/// Handles that were handed out again.
+		std::size_t reused;
+		/// Handles that had to be created because the pool was empty.
+		std::size_t created;
+	};
+
+	/// @param capacity The maximum number of idle handles. Handles returned to a full pool are freed.
+	RequestPool(std::size_t capacity = 64) noexcept : _capacity{ capacity } {}
+	RequestPool(const RequestPool& copy) = delete;
+	RequestPool(RequestPool&& move)      = delete;
+	~RequestPool()
+	{
+		for (const auto handle : _handles) {
+			curl_easy_cleanup(handle);
+		}
+	}
+
+	/// Sets the option on all idle handles and on every handle that is handed out from now on. Strings are
+	/// copied. Options which the request keeps track of, like the URL, the method and the credentials, must be
+	/// set with `BasicRequest::set_option()` instead, since the request would not see them here.
+	template<CURLoption Option>
+	void set_base_option(detail::option_type<Option> value)
+	{
+		static_assert(!detail::is_tracked_option<Option>, "the option must be set on the request");
+
+		std::function<CURLcode(CURL*)> setter{};
+		if constexpr (std::is_same_v<detail::option_type<Option>, const char*>) {
+			if (value == nullptr) {
+				setter = [](CURL* handle) { return curl_easy_setopt(handle, Option, nullptr); };
+			} else {
+				setter = [value = std::string{ value }](CURL* handle) {
+					return curl_easy_setopt(handle, Option, value.c_str());
+				};
+			}
+		} else {
+			setter = [value](CURL* handle) { return curl_easy_setopt(handle, Option, value); };
+		}
+
+		std::lock_guard<std::mutex> lock{ _mutex };
+		for (const auto handle : _handles) {
+			CURLIO_EASY_ASSERT(setter(handle));
+		}
+		_base_options.push_back(std::move(setter));
+	}
+	/// Returns an idle handle or creates a new one. The handle has the base options set.
+	CURLIO_NO_DISCARD CURL* acquire()
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		if (!_handles.empty()) {
+			const auto handle = _handles.back();
+			_handles.pop_back();
+			++_reused;
+			return handle;
+		}
+
+		const auto handle = curl_easy_init();
+		try {
+			for (const auto& setter : _base_options) {
+				CURLIO_EASY_ASSERT(setter(handle));
+			}
+		} catch (...) {
+			curl_easy_cleanup(handle);
+			throw;
+		}
+		++_created;
+		return handle;
+	}
+	/// Resets the handle and keeps it for reuse. The handle must not be in use anymore.
+	void release(CURL* handle) noexcept
+	{
+		curl_easy_reset(handle);
+
+		std::lock_guard<std::mutex> lock{ _mutex };
+		if (_handles.size() < _capacity) {
+			bool valid = true;
+			for (const auto& setter : _base_options) {
+				if (CURLIO_EASY_CHECK(setter(handle))) {
+					valid = false;
+					break;
+				}
+			}
+			if (valid) {
+				_handles.push_back(handle);
+				return;
+			}
+		}
+		curl_easy_cleanup(handle);
+	}
+	CURLIO_NO_DISCARD Statistics get_statistics() const noexcept { return { _reused, _created }; }
+	/// Returns the number of idle handles.
+	CURLIO_NO_DISCARD std::size_t size() const
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		return _handles.size();
+	}
+
+	RequestPool& operator=(const RequestPool& copy) = delete;
+	RequestPool& operator=(RequestPool&& move)      = delete;
+
+private:
+	mutable std::mutex _mutex{};
+	std::size_t _capacity;
+	std::vector<CURL*> _handles{};
+	std::vector<std::function<CURLcode(CURL*)>> _base_options{};
+	std::atomic<std::size_t> _reused{ 0 };
+	std::atomic<std::size_t> _created{ 0 };
+};
+
+} // namespace cURLio
@@ -0,0 +1,76 @@
+/**
+ * @file
+ *
+ * Tuning of the sockets that a session opens for cURL.
+ */
+#pragma once
+
+#include "detail/asio_include.hpp"
+
+#include <functional>
+
+#if !defined(_WIN32)
+#	include <netinet/in.h>
+#	include <netinet/tcp.h>
+#	include <sys/socket.h>
+#endif
+
+namespace cURLio {
+
+/// Called for every socket that is opened by a session before it is connected. The policy must not throw and
+/// should ignore options which are not supported by the system.
+using SocketPolicy = std::function<void(CURLIO_ASIO_NS::ip::tcp::socket& socket)>;
+
+namespace detail {
+
+/// Sets an integer socket option that ASIO does not provide. Failures are ignored.
+inline void set_integer_option(CURLIO_ASIO_NS::ip::tcp::socket& socket, int level, int name,
+                               int value) noexcept
+{
+#if !defined(_WIN32)
+	static_cast<void>(::setsockopt(socket.native_handle(), level, name, &value, sizeof(value)));
+#endif
+}
+
+} // namespace detail
+
+namespace socket_policy {
+
+/**
+ * For small request/response exchanges. Disables Nagle's algorithm (cURL does this too by default), asks for
+ * immediate acknowledgements (`TCP_QUICKACK`), busy polls the device queue while waiting for data
+ * (`SO_BUSY_POLL`) and sends the request with the SYN (`TCP_FASTOPEN_CONNECT`) if the server allows it.
+ * Policies run before the socket connects, and Linux does not keep `TCP_QUICKACK`: it only covers the
+ * handshake, after which the kernel may return to delayed acknowledgements. Options that are not available
+ * on the system are skipped. Raising `SO_BUSY_POLL` above `net.core.busy_read` requires `CAP_NET_ADMIN`.
+ */
+inline SocketPolicy low_latency(int busy_poll_microseconds = 50)
+{
+	return [busy_poll_microseconds](CURLIO_ASIO_NS::ip::tcp::socket& socket) {
+		detail::asio_error_code ec{};
+		static_cast<void>(socket.set_option(CURLIO_ASIO_NS::ip::tcp::no_delay{ true }, ec));
+#if defined(TCP_QUICKACK)
+		detail::set_integer_option(socket, IPPROTO_TCP, TCP_QUICKACK, 1);
+#endif
+#if defined(SO_BUSY_POLL)
+		detail::set_integer_option(socket, SOL_SOCKET, SO_BUSY_POLL, busy_poll_microseconds);
+#endif
+#if defined(TCP_FASTOPEN_CONNECT)
+		detail::set_integer_option(socket, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, 1);
+#endif
+	};
+}
+
+/// For large transfers over links with a high bandwidth-delay product. Sets fixed receive and send buffers,
+/// which also disables the automatic buffer tuning of Linux for the socket.
+inline SocketPolicy bulk_throughput(int buffer_size = 4 * 1024 * 1024)
+{
+	return [buffer_size](CURLIO_ASIO_NS::ip::tcp::socket& socket) {
+		detail::asio_error_code ec{};
+		static_cast<void>(socket.set_option(CURLIO_ASIO_NS::socket_base::receive_buffer_size{ buffer_size }, ec));
+		static_cast<void>(socket.set_option(CURLIO_ASIO_NS::socket_base::send_buffer_size{ buffer_size }, ec));
+	};
+}
+
+} // namespace socket_policy
+} // namespace cURLio
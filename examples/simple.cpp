@@ -20,8 +20,8 @@ int main(int argc, char** argv)
 	  [&]() -> awaitable<void> {
 		  // Create request and set options.
 		  auto request = std::make_shared<cURLio::Request>(session);
-		  curl_easy_setopt(request->native_handle(), CURLOPT_URL, "http://example.com");
-		  curl_easy_setopt(request->native_handle(), CURLOPT_USERAGENT, "cURLio");
+		  request->set_option<CURLOPT_URL>("http://example.com");
+		  request->set_option<CURLOPT_USERAGENT>("cURLio");
 
 		  // Launches the request which will then run in the background.
 		  auto response = co_await session.async_start(request, use_awaitable);